@@ -24,6 +24,7 @@
 
 #include <X11/keysym.h>
 #include <unistd.h>
+#include <sys/socket.h>
 
 #include "mfem.hpp"
 #include "lib/visual.hpp"
@@ -72,10 +73,20 @@ const char *window_titles[] = { "GLVis [scalar data]",
 istream *script = NULL;
 int scr_running = 0;
 int scr_level = 0;
+bool scr_redraw = false; // the scene changed since the last redraw
 Vector *init_nodes = NULL;
 double scr_min_val, scr_max_val;
 
 Array<istream *> input_streams;
+// the meshes and solutions read from the parallel input streams, kept for the
+// incremental updates (passed to the communication thread)
+Array<Mesh *> input_mesh_pieces;
+Array<GridFunction *> input_gf_pieces;
+// the mesh read from the input stream(s) or files is 1D, extruded to 2D
+bool input_mesh_1d = false;
+// the mesh of a serial "mesh" or "solution" session, read by the server before
+// the session process was forked (see -sm), or NULL
+Mesh *session_mesh = NULL;
 
 extern char **environ;
 
@@ -101,11 +112,15 @@ int ReadParMeshAndGridFunction(int np, const char *mesh_prefix,
 
 int ReadInputStreams();
 
-void CloseInputStreams(bool);
+istream *OpenInputStream(socketstream *isock, string &data_type);
 
-GridFunction *ProjectVectorFEGridFunction(GridFunction*);
+void CloseInputStreams(bool);
 
-void Extrude1DMeshAndSolution(Mesh **mesh_p, GridFunction **grid_f_p,
+// Extrude a 1D mesh and its solution to 2D for the vector and mesh-only
+// (displacement) scenes; returns true if the mesh was extruded. Scalar
+// solutions on 1D meshes are drawn without extrusion as line plots, see
+// VisualizationSceneSolution1d.
+bool Extrude1DMeshAndSolution(Mesh **mesh_p, GridFunction **grid_f_p,
                               Vector *sol);
 
 // Read the content of an input stream (e.g. from socket/file)
@@ -152,8 +167,8 @@ int ReadStream(istream &is, const string &data_type)
    }
    else if (data_type == "fem2d_gf_data" || data_type == "fem2d_gf_data_keys")
    {
-      mesh = new Mesh(is, 1, 0, fix_elem_orient);
-      grid_f = new GridFunction(mesh, is);
+      mesh = ReadMesh(is, fix_elem_orient);
+      grid_f = ReadGridFunction(mesh, is);
       if (data_type == "fem2d_gf_data_keys")
       {
          is >> keys;
@@ -162,8 +177,8 @@ int ReadStream(istream &is, const string &data_type)
    else if (data_type == "vfem2d_gf_data" || data_type == "vfem2d_gf_data_keys")
    {
       field_type = 1;
-      mesh = new Mesh(is, 1, 0, fix_elem_orient);
-      grid_f = new GridFunction(mesh, is);
+      mesh = ReadMesh(is, fix_elem_orient);
+      grid_f = ReadGridFunction(mesh, is);
       if (data_type == "vfem2d_gf_data_keys")
       {
          is >> keys;
@@ -171,8 +186,8 @@ int ReadStream(istream &is, const string &data_type)
    }
    else if (data_type == "fem3d_gf_data" || data_type == "fem3d_gf_data_keys")
    {
-      mesh = new Mesh(is, 1, 0, fix_elem_orient);
-      grid_f = new GridFunction(mesh, is);
+      mesh = ReadMesh(is, fix_elem_orient);
+      grid_f = ReadGridFunction(mesh, is);
       if (data_type == "fem3d_gf_data_keys")
       {
          is >> keys;
@@ -181,8 +196,8 @@ int ReadStream(istream &is, const string &data_type)
    else if (data_type == "vfem3d_gf_data" || data_type == "vfem3d_gf_data_keys")
    {
       field_type = 1;
-      mesh = new Mesh(is, 1, 0, fix_elem_orient);
-      grid_f = new GridFunction(mesh, is);
+      mesh = ReadMesh(is, fix_elem_orient);
+      grid_f = ReadGridFunction(mesh, is);
       if (data_type == "vfem3d_gf_data_keys")
       {
          is >> keys;
@@ -190,16 +205,34 @@ int ReadStream(istream &is, const string &data_type)
    }
    else if (data_type == "solution")
    {
-      mesh = new Mesh(is, 1, 0, fix_elem_orient);
-      grid_f = new GridFunction(mesh, is);
+      mesh = session_mesh ? session_mesh : ReadCachedMesh(is, fix_elem_orient);
+      session_mesh = NULL;
+      grid_f = ReadGridFunction(mesh, is);
       field_type = (grid_f->VectorDim() == 1) ? 0 : 1;
    }
    else if (data_type == "mesh")
    {
-      mesh = new Mesh(is, 1, 0, fix_elem_orient);
+      mesh = session_mesh ? session_mesh : ReadCachedMesh(is, fix_elem_orient);
+      session_mesh = NULL;
       SetMeshSolution(mesh, grid_f, save_coloring);
       field_type = 2;
    }
+   else if (IsBinaryDataType(data_type))
+   {
+      if (ReadBinaryData(data_type, is, &mesh, &grid_f, fix_elem_orient))
+      {
+         field_type = -1;
+      }
+      else if (grid_f)
+      {
+         field_type = (grid_f->VectorDim() == 1) ? 0 : 1;
+      }
+      else
+      {
+         SetMeshSolution(mesh, grid_f, save_coloring);
+         field_type = 2;
+      }
+   }
    else if (data_type == "raw_scalar_2d")
    {
       Array<Array<double> *> vertices;
@@ -326,11 +359,11 @@ int ReadStream(istream &is, const string &data_type)
    {
       if (grid_f)
       {
-         Extrude1DMeshAndSolution(&mesh, &grid_f, NULL);
+         input_mesh_1d = Extrude1DMeshAndSolution(&mesh, &grid_f, NULL);
       }
       else
       {
-         Extrude1DMeshAndSolution(&mesh, NULL, &sol);
+         input_mesh_1d = Extrude1DMeshAndSolution(&mesh, NULL, &sol);
       }
    }
 
@@ -346,6 +379,189 @@ int InitVis(int t)
                             window_w, window_h);
 }
 
+// The solution files played back with -gs, or with the script command
+// "sequence", see SolutionSequence
+SolutionSequence *sequence = NULL;
+int seq_frame = 0; // the shown frame
+int seq_dir = 1;   // direction of stepping and playback: +1 or -1
+bool seq_play = false;
+double seq_fps = 10.0; // frames per second in the playback
+PlaybackTimer seq_timer;
+const int seq_default_cache = 32; // frames kept in memory
+
+// Show frame 'k' of the sequence, without redrawing the window, and start
+// reading the following frames
+static bool ShowSequenceFrame(int k)
+{
+   GridFunction *g = sequence->NewGridFunction(k);
+   if (!g)
+   {
+      cout << "Sequence: can not read " << sequence->FileName(k) << endl;
+      return false;
+   }
+   UpdateVisualizationScene(vs, mesh, g, sol);
+   delete grid_f;
+   grid_f = g;
+   seq_frame = k;
+   sequence->Prefetch(k, seq_dir);
+   cout << "Sequence: " << sequence->FileName(k) << " (" << k+1 << " of "
+        << sequence->Size() << ")" << endl;
+   return true;
+}
+
+static void SequenceIdleFunc();
+
+static void ToggleSequencePlayback(int dir)
+{
+   seq_play = !seq_play;
+   if (seq_play)
+   {
+      seq_dir = dir;
+      const int last = (dir > 0) ? sequence->Size()-1 : 0;
+      if (seq_frame == last)
+      {
+         // start again from the other end
+         ShowSequenceFrame(sequence->Size()-1 - last);
+         SendExposeEvent();
+      }
+      else
+      {
+         sequence->Prefetch(seq_frame, seq_dir);
+      }
+      seq_timer.Start(seq_fps);
+      cout << "Sequence: playback at " << seq_timer.FPS()
+           << " frames/s" << endl;
+      AddIdleFunc(SequenceIdleFunc);
+   }
+   else
+   {
+      cout << "Sequence: playback stopped" << endl;
+      RemoveIdleFunc(SequenceIdleFunc);
+   }
+}
+
+static void SequenceIdleFunc()
+{
+   if (!seq_timer.Due())
+   {
+      return;
+   }
+   const int k = seq_frame + seq_dir;
+   if (k < 0 || k >= sequence->Size() || !ShowSequenceFrame(k))
+   {
+      ToggleSequencePlayback(seq_dir);
+      return;
+   }
+   SendExposeEvent();
+}
+
+static void SequenceStep(int step)
+{
+   if (!sequence)
+   {
+      return;
+   }
+   if (seq_play)
+   {
+      ToggleSequencePlayback(seq_dir);
+   }
+   int k = seq_frame + step;
+   k = (k < 0) ? 0 : (k >= sequence->Size()) ? sequence->Size()-1 : k;
+   if (k != seq_frame)
+   {
+      seq_dir = (step > 0) ? 1 : -1;
+      if (ShowSequenceFrame(k))
+      {
+         SendExposeEvent();
+      }
+   }
+}
+
+// Keys for the frames of the sequence, if there is one, or else of the history
+// of the stream solutions (see SolutionHistory): PageUp/PageDown step, End
+// shows the last (newest) frame, Home plays forward (Shift+Home backward, only
+// for the sequence)
+static void FrameBackKey()
+{
+   if (sequence) { SequenceStep(-1); }
+   else if (glvis_command) { glvis_command->HistoryStep(-1); }
+}
+static void FrameForwardKey()
+{
+   if (sequence) { SequenceStep(+1); }
+   else if (glvis_command) { glvis_command->HistoryStep(+1); }
+}
+static void FrameLastKey()
+{
+   if (sequence) { SequenceStep(sequence->Size()); }
+   else if (glvis_command) { glvis_command->HistoryNewest(); }
+}
+static void FramePlaybackKey(GLenum state)
+{
+   if (sequence) { ToggleSequencePlayback((state & ShiftMask) ? -1 : +1); }
+   else if (glvis_command) { glvis_command->ToggleHistoryPlayback(); }
+}
+
+// Register the keys above, once per process
+static void RegisterFrameKeys()
+{
+   static bool registered = false;
+   if (!registered)
+   {
+      auxKeyFunc(XK_Prior, FrameBackKey);
+      auxKeyFunc(XK_Next, FrameForwardKey);
+      auxKeyFunc(XK_End, FrameLastKey);
+      auxModKeyFunc(XK_Home, FramePlaybackKey);
+      registered = true;
+   }
+}
+
+// Play back the files of 'pattern' on the current mesh; the first one is the
+// shown solution. See SolutionSequence.
+static bool StartSequence(const char *pattern, int first, int last, int step,
+                          int cache_size)
+{
+   if (input_mesh_1d)
+   {
+      cout << "Sequence: extruded 1D meshes are not supported" << endl;
+      return false;
+   }
+   if (!SolutionSequence::IsPattern(pattern))
+   {
+      cout << "Sequence: not a pattern with one integer conversion: "
+           << pattern << endl;
+      return false;
+   }
+   sequence = new SolutionSequence(pattern, first, last, step, mesh,
+                                   cache_size);
+   if (!sequence->Good())
+   {
+      cout << "Sequence: can not read " << sequence->FileName(0)
+           << " (or not a pattern: " << pattern << ")" << endl;
+      delete sequence;
+      sequence = NULL;
+      return false;
+   }
+   RegisterFrameKeys();
+   seq_frame = 0;
+   seq_dir = 1;
+   seq_play = false;
+   sequence->Prefetch(0, seq_dir);
+   return true;
+}
+
+// Delete the sequence, e.g. before its mesh is replaced; the current solution
+// should not be one of its frames
+static void StopSequence()
+{
+   if (seq_play)
+   {
+      ToggleSequencePlayback(seq_dir);
+   }
+   delete sequence;
+   sequence = NULL;
+}
+
 // Visualize the data in the global variables mesh, sol/grid_f, etc
 void StartVisualization(int field_type)
 {
@@ -365,9 +581,11 @@ void StartVisualization(int field_type)
    if (input_streams.Size() > 0)
    {
       auxModKeyFunc(XK_space, ThreadsPauseFunc);
+      RegisterFrameKeys();
       glvis_command = new GLVisCommand(&vs, &mesh, &grid_f, &sol, &keep_attr,
                                        &fix_elem_orient);
-      comm_thread = new communication_thread(input_streams);
+      comm_thread = new communication_thread(input_streams, input_mesh_pieces,
+                                             input_gf_pieces, input_mesh_1d);
    }
 
    double mesh_range = -1.0;
@@ -377,7 +595,25 @@ void StartVisualization(int field_type)
       {
          grid_f->GetNodalValues(sol);
       }
-      if (mesh->SpaceDimension() == 2)
+      if (mesh->SpaceDimension() == 1)
+      {
+         VisualizationSceneSolution1d *vss;
+         if (field_type == 2)
+         {
+            Set_Palette(4);
+         }
+         vs = vss = new VisualizationSceneSolution1d(*mesh, sol);
+         if (grid_f)
+         {
+            vss->SetGridFunction(*grid_f);
+         }
+         if (field_type == 2)
+         {
+            vss->ToggleDrawAxes();
+            vss->ToggleDrawMesh();
+         }
+      }
+      else if (mesh->SpaceDimension() == 2)
       {
          VisualizationSceneSolution *vss;
          if (field_type == 2)
@@ -479,7 +715,8 @@ void StartVisualization(int field_type)
          vs->SetValueRange(-mesh_range, mesh_range);
          vs->SetAutoscale(0);
       }
-      if (mesh->SpaceDimension() == 2 && field_type == 2)
+      if (mesh->SpaceDimension() == 1 ||
+          (mesh->SpaceDimension() == 2 && field_type == 2))
       {
          SetVisualizationScene(vs, 2, keys.c_str());
       }
@@ -499,47 +736,209 @@ void StartVisualization(int field_type)
       glvis_command = NULL;
    }
    delete grid_f; grid_f = NULL;
+   StopSequence(); // started by the script command "sequence"
    delete mesh; mesh = NULL;
    cout << "GLVis window closed." << endl;
 }
 
-int ScriptReadSolution(istream &scr, Mesh **mp, GridFunction **sp)
+// Read the mesh and the solution of the script command "solution"; returns 1
+// if the mesh file can not be opened, 2 for the solution file. Thread-safe.
+static int LoadScriptSolution(const string &mword, const string &sword,
+                              Mesh **mp, GridFunction **sp)
 {
-   string mword,sword;
-
-   cout << "Script: solution: " << flush;
-   // read the mesh
-   scr >> ws >> mword; // mesh filename (can't contain spaces)
-   cout << "mesh: " << mword << "; " << flush;
    named_ifgzstream imesh(mword.c_str());
    if (!imesh)
    {
-      cout << "Can not open mesh file: " << mword << endl;
       return 1;
    }
-   *mp = new Mesh(imesh, 1, 0, fix_elem_orient);
+   *mp = ReadCachedMesh(imesh, fix_elem_orient);
 
    // read the solution (GridFunction)
-   scr >> ws >> sword;
    if (sword == mword) // mesh and solution in the same file
    {
-      cout << "solution: " << mword << endl;
-      *sp = new GridFunction(*mp, imesh);
+      MappedInput msol(mword.c_str(), long(streamoff(imesh.tellg())));
+      *sp = msol.LoadGridFunction(*mp);
+      if (!*sp)
+      {
+         *sp = ReadGridFunction(*mp, imesh);
+      }
    }
    else
    {
-      cout << "solution: " << sword << endl;
-      ifgzstream isol(sword.c_str());
+      ifpgzstream isol(sword.c_str());
       if (!isol)
       {
-         cout << "Can not open solution file: " << sword << endl;
          delete *mp; *mp = NULL;
          return 2;
       }
-      *sp = new GridFunction(*mp, isol);
+      MappedInput msol(sword.c_str());
+      *sp = msol.LoadGridFunction(*mp);
+      if (!*sp)
+      {
+         *sp = ReadGridFunction(*mp, isol);
+      }
+   }
+   return 0;
+}
+
+// Read the mesh of the script command "mesh"; returns 1 if the file can not
+// be opened. Thread-safe.
+static int LoadScriptMesh(const string &word, Mesh **mp)
+{
+   named_ifgzstream imesh(word.c_str());
+   if (!imesh)
+   {
+      return 1;
+   }
+   *mp = ReadMesh(imesh, fix_elem_orient);
+   return 0;
+}
+
+// The files of the next "solution" or "mesh" command of the script, read by a
+// background thread while the current frame is drawn
+struct ScriptReadAhead
+{
+   string mesh_file, sol_file; // 'sol_file' is empty for "mesh"
+   Mesh *mesh;
+   GridFunction *gf;
+   int err;
+   pthread_t thread;
+};
+
+static ScriptReadAhead *scr_read_ahead = NULL;
+
+static void *ScriptReadAheadThread(void *p)
+{
+   ScriptReadAhead *ra = (ScriptReadAhead *)p;
+   if (ra->sol_file.empty())
+   {
+      ra->err = LoadScriptMesh(ra->mesh_file, &ra->mesh);
+   }
+   else
+   {
+      ra->err = LoadScriptSolution(ra->mesh_file, ra->sol_file, &ra->mesh,
+                                   &ra->gf);
+   }
+   return NULL;
+}
+
+// Wait for the read-ahead thread; if it read the given files, return true and
+// its results, otherwise delete them.
+static bool TakeScriptReadAhead(const string &mesh_file,
+                                const string &sol_file, Mesh **mp,
+                                GridFunction **sp, int &err)
+{
+   ScriptReadAhead *ra = scr_read_ahead;
+   if (!ra)
+   {
+      return false;
+   }
+   scr_read_ahead = NULL;
+   pthread_join(ra->thread, NULL);
+   const bool match = (ra->mesh_file == mesh_file &&
+                       ra->sol_file == sol_file);
+   if (match)
+   {
+      *mp = ra->mesh;
+      if (sp) { *sp = ra->gf; }
+      err = ra->err;
+   }
+   else
+   {
+      delete ra->gf;
+      delete ra->mesh;
+   }
+   delete ra;
+   return match;
+}
+
+static void CancelScriptReadAhead()
+{
+   int err;
+   TakeScriptReadAhead(string(), string(), NULL, NULL, err);
+}
+
+// Find the next "solution" or "mesh" command in the script, without moving
+// past the current command, and start reading its files in the background.
+// The files are used only if the command is reached with the same files.
+static void StartScriptReadAhead()
+{
+   istream &scr = *script;
+   if (scr_read_ahead || !scr.good())
+   {
+      return;
+   }
+   const streampos pos = scr.tellg();
+   if (pos == streampos(-1))
+   {
+      return;
+   }
+   ScriptReadAhead *ra = NULL;
+   string word;
+   const int max_words = 1000;
+   for (int i = 0; i < max_words && scr >> ws && scr.good(); i++)
+   {
+      if (scr.peek() == '#')
+      {
+         getline(scr, word);
+         continue;
+      }
+      scr >> word;
+      if (word == "solution" || word == "mesh")
+      {
+         ra = new ScriptReadAhead;
+         ra->mesh = NULL;
+         ra->gf = NULL;
+         ra->err = 0;
+         scr >> ws >> ra->mesh_file;
+         if (word == "solution")
+         {
+            scr >> ws >> ra->sol_file;
+         }
+         break;
+      }
+      if (word == "psolution" || word == "sequence")
+      {
+         break;
+      }
+   }
+   scr.clear();
+   scr.seekg(pos);
+   if (ra && pthread_create(&ra->thread, NULL, ScriptReadAheadThread, ra) != 0)
+   {
+      delete ra;
+      ra = NULL;
+   }
+   scr_read_ahead = ra;
+}
+
+int ScriptReadSolution(istream &scr, Mesh **mp, GridFunction **sp)
+{
+   string mword,sword;
+
+   cout << "Script: solution: " << flush;
+   scr >> ws >> mword; // mesh filename (can't contain spaces)
+   cout << "mesh: " << mword << "; " << flush;
+   scr >> ws >> sword;
+   cout << "solution: " << sword << endl;
+
+   int err;
+   if (!TakeScriptReadAhead(mword, sword, mp, sp, err))
+   {
+      err = LoadScriptSolution(mword, sword, mp, sp);
+   }
+   if (err == 1)
+   {
+      cout << "Can not open mesh file: " << mword << endl;
+      return 1;
+   }
+   if (err == 2)
+   {
+      cout << "Can not open solution file: " << sword << endl;
+      return 2;
    }
 
-   Extrude1DMeshAndSolution(mp, sp, NULL);
+   input_mesh_1d = Extrude1DMeshAndSolution(mp, sp, NULL);
 
    return 0;
 }
@@ -573,7 +972,7 @@ int ScriptReadParSolution(istream &scr, Mesh **mp, GridFunction **sp)
                                     sol_prefix.c_str(), mp, sp, keep_attr);
    if (!err)
    {
-      Extrude1DMeshAndSolution(mp, sp, NULL);
+      input_mesh_1d = Extrude1DMeshAndSolution(mp, sp, NULL);
    }
    return err;
 }
@@ -585,16 +984,17 @@ int ScriptReadDisplMesh(istream &scr, Mesh **mp, GridFunction **sp)
 
    cout << "Script: mesh: " << flush;
    scr >> ws >> word;
+   int err;
+   if (!TakeScriptReadAhead(word, string(), &m, NULL, err))
    {
-      named_ifgzstream imesh(word.c_str());
-      if (!imesh)
-      {
-         cout << "Can not open mesh file: " << word << endl;
-         return 1;
-      }
-      cout << word << endl;
-      m = new Mesh(imesh, 1, 0, fix_elem_orient);
+      err = LoadScriptMesh(word, &m);
+   }
+   if (err)
+   {
+      cout << "Can not open mesh file: " << word << endl;
+      return 1;
    }
+   cout << word << endl;
    Extrude1DMeshAndSolution(&m, NULL, NULL);
    if (init_nodes == NULL)
    {
@@ -638,17 +1038,21 @@ int ScriptReadDisplMesh(istream &scr, Mesh **mp, GridFunction **sp)
    return 0;
 }
 
-void ExecuteScriptCommand()
+// Execute the next command of the script. The window is not redrawn: the
+// commands that change the scene set 'scr_redraw'. Returns true if the
+// command ends a batch of commands: a screenshot or the end of the script.
+bool ExecuteScriptCommand()
 {
    if (!script)
    {
       cout << "No script stream defined! (Bug?)" << endl;
-      return;
+      return true;
    }
 
    istream &scr = *script;
    string word;
    int done_one_command = 0;
+   bool end_batch = false;
    while (!done_one_command)
    {
       scr >> ws;
@@ -656,7 +1060,7 @@ void ExecuteScriptCommand()
       {
          cout << "End of script." << endl;
          scr_level = 0;
-         return;
+         return true;
       }
       if (scr.peek() == '#')
       {
@@ -715,43 +1119,12 @@ void ExecuteScriptCommand()
          if (new_m->SpaceDimension() == mesh->SpaceDimension() &&
              new_g->VectorDim() == grid_f->VectorDim())
          {
-            if (new_m->SpaceDimension() == 2)
-            {
-               if (new_g->VectorDim() == 1)
-               {
-                  VisualizationSceneSolution *vss =
-                     dynamic_cast<VisualizationSceneSolution *>(vs);
-                  new_g->GetNodalValues(sol);
-                  vss->NewMeshAndSolution(new_m, &sol, new_g);
-               }
-               else
-               {
-                  VisualizationSceneVector *vsv =
-                     dynamic_cast<VisualizationSceneVector *>(vs);
-                  vsv->NewMeshAndSolution(*new_g);
-               }
-            }
-            else
-            {
-               if (new_g->VectorDim() == 1)
-               {
-                  VisualizationSceneSolution3d *vss =
-                     dynamic_cast<VisualizationSceneSolution3d *>(vs);
-                  new_g->GetNodalValues(sol);
-                  vss->NewMeshAndSolution(new_m, &sol, new_g);
-               }
-               else
-               {
-                  new_g = ProjectVectorFEGridFunction(new_g);
-                  VisualizationSceneVector3d *vss =
-                     dynamic_cast<VisualizationSceneVector3d *>(vs);
-                  vss->NewMeshAndSolution(new_m, new_g);
-               }
-            }
+            UpdateVisualizationScene(vs, new_m, new_g, sol);
             delete grid_f; grid_f = new_g;
+            StopSequence(); // its frames are on the replaced mesh
             delete mesh; mesh = new_m;
 
-            vs->Draw();
+            scr_redraw = true;
          }
          else
          {
@@ -760,12 +1133,52 @@ void ExecuteScriptCommand()
             delete new_m;
          }
       }
+      else if (word == "sequence")
+      {
+         int first, last, step;
+         scr >> ws >> word >> first >> last >> step;
+         StopSequence();
+         if (StartSequence(word.c_str(), first, last, step,
+                           seq_default_cache) &&
+             ShowSequenceFrame(0))
+         {
+            scr_redraw = true;
+         }
+      }
+      else if (word == "next")
+      {
+         if (!sequence)
+         {
+            cout << "Script: no sequence!" << endl;
+         }
+         else if (seq_frame+1 < sequence->Size())
+         {
+            seq_dir = 1;
+            if (ShowSequenceFrame(seq_frame+1))
+            {
+               scr_redraw = true;
+            }
+         }
+         else
+         {
+            cout << "Script: end of the sequence." << endl;
+         }
+      }
       else if (word == "screenshot")
       {
          scr >> ws >> word;
 
          cout << "Script: screenshot: " << flush;
 
+         // draw the changes of the batch once, while the next solution is
+         // read in the background
+         StartScriptReadAhead();
+         if (scr_redraw)
+         {
+            MyExpose();
+            scr_redraw = false;
+         }
+         end_batch = true;
          if (Screenshot(word.c_str(), true))
          {
             cout << "Screenshot(" << word << ") failed." << endl;
@@ -788,7 +1201,7 @@ void ExecuteScriptCommand()
          scr >> vs->ViewCenterX >> vs->ViewCenterY;
          cout << "Script: viewcenter: "
               << vs->ViewCenterX << ' ' << vs->ViewCenterY << endl;
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word ==  "perspective")
       {
@@ -807,7 +1220,7 @@ void ExecuteScriptCommand()
             cout << '?';
          }
          cout << endl;
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word ==  "light")
       {
@@ -826,7 +1239,7 @@ void ExecuteScriptCommand()
             cout << '?';
          }
          cout << endl;
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "view")
       {
@@ -834,7 +1247,7 @@ void ExecuteScriptCommand()
          scr >> theta >> phi;
          cout << "Script: view: " << theta << ' ' << phi << endl;
          vs->SetView(theta, phi);
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "zoom")
       {
@@ -842,7 +1255,7 @@ void ExecuteScriptCommand()
          scr >> factor;
          cout << "Script: zoom: " << factor << endl;
          vs->Zoom(factor);
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "shading")
       {
@@ -865,7 +1278,7 @@ void ExecuteScriptCommand()
          {
             vs->SetShading(s, false);
             cout << word << endl;
-            MyExpose();
+            scr_redraw = true;
          }
          else
          {
@@ -879,7 +1292,7 @@ void ExecuteScriptCommand()
          cout << "Script: subdivisions: " << flush;
          vs->SetRefineFactors(t, b);
          cout << t << ' ' << b << endl;
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "valuerange")
       {
@@ -888,7 +1301,7 @@ void ExecuteScriptCommand()
          cout << "Script: valuerange: " << flush;
          vs->SetValueRange(min, max);
          cout << min << ' ' << max << endl;
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "autoscale")
       {
@@ -922,15 +1335,20 @@ void ExecuteScriptCommand()
          cout << "Script: window: " << window_x << ' ' << window_y
               << ' ' << window_w << ' ' << window_h << endl;
          MoveResizeWindow(window_x, window_y, window_w, window_h);
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "keys")
       {
          scr >> keys;
          cout << "Script: keys: '" << keys << "'" << endl;
+         if (scr_redraw)
+         {
+            // some keys use the drawn image, e.g. for screenshots
+            MyExpose();
+         }
          // SendKeySequence(keys.c_str());
          CallKeySequence(keys.c_str());
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "palette")
       {
@@ -942,7 +1360,7 @@ void ExecuteScriptCommand()
          {
             vs->EventUpdateColors();
          }
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "toggle_attributes")
       {
@@ -964,7 +1382,7 @@ void ExecuteScriptCommand()
          scr.get(); // read the end symbol: ';'
          cout << endl;
          vs->ToggleAttributes(attr_list);
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "rotmat")
       {
@@ -975,7 +1393,7 @@ void ExecuteScriptCommand()
             cout << ' ' << vs->rotmat[i];
          }
          cout << endl;
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "camera")
       {
@@ -988,7 +1406,7 @@ void ExecuteScriptCommand()
          }
          cout << endl;
          vs->cam.Set(cam);
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "scale")
       {
@@ -998,7 +1416,7 @@ void ExecuteScriptCommand()
          cout << ' ' << scale;
          cout << endl;
          vs->Scale(scale);
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "translate")
       {
@@ -1008,7 +1426,7 @@ void ExecuteScriptCommand()
          cout << ' ' << x << ' ' << y << ' ' << z;
          cout << endl;
          vs->Translate(x, y, z);
-         MyExpose();
+         scr_redraw = true;
       }
       else if (word == "plot_caption")
       {
@@ -1016,7 +1434,7 @@ void ExecuteScriptCommand()
          scr >> ws >> delim;
          getline(scr, plot_caption, delim);
          vs->UpdateCaption(); // turn on or off the caption
-         MyExpose();
+         scr_redraw = true;
       }
       else
       {
@@ -1025,13 +1443,27 @@ void ExecuteScriptCommand()
 
       done_one_command = 1;
    }
+   return end_batch;
 }
 
 void ScriptControl();
 
 void ScriptIdleFunc()
 {
-   ExecuteScriptCommand();
+   // execute the commands up to the next screenshot, or up to the end of the
+   // current block (after which the script pauses), and redraw once
+   bool end_batch;
+   do
+   {
+      end_batch = ExecuteScriptCommand();
+   }
+   while (!end_batch && scr_level > 0);
+   if (scr_redraw)
+   {
+      StartScriptReadAhead();
+      MyExpose();
+      scr_redraw = false;
+   }
    if (scr_level == 0)
    {
       ScriptControl();
@@ -1116,11 +1548,13 @@ void PlayScript(istream &scr)
    }
 
    scr_level = scr_running = 0;
+   scr_redraw = false;
    auxKeyFunc(XK_space, ScriptControl);
    script = &scr;
    keys.clear();
 
    StartVisualization((grid_f->VectorDim() == 1) ? 0 : 1);
+   CancelScriptReadAhead();
 
    delete init_nodes; init_nodes = NULL;
 
@@ -1130,21 +1564,383 @@ void PlayScript(istream &scr)
    script = NULL;
 }
 
-
-int main (int argc, char *argv[])
+// A connection to the GLVis server, with its header read
+struct ServerConnection
 {
-   // variables for command line arguments
-   bool        multi_session = true;   // not added as option
-   bool        mac           = false;
-   const char *stream_file   = string_none;
-   const char *script_file   = string_none;
-   const char *font_name     = string_default;
-   int         portnum       = 19916;
-   bool        secure        = socketstream::secure_default;
-   int         multisample   = GetMultisample();
-   double      line_width    = Get_LineWidth();
-   double      ms_line_width = Get_MS_LineWidth();
-   int         geom_ref_type = Quadrature1D::ClosedUniform;
+   socketstream *sock;
+   istream *input;   // sock or a decompressing stream
+   string data_type;
+   int nproc, proc;  // for "parallel" connections
+};
+
+// Accepts the connections to the GLVis server and groups them into sessions:
+// a serial session is one connection, a parallel session is one connection
+// from every rank. The accept, the TLS handshake and the header of the ranks
+// of a parallel session are processed concurrently, so that all ranks do not
+// wait for the handshakes of the others. No threads are running when
+// NextSession() returns, so the server can fork.
+class ServerAcceptor
+{
+private:
+   socketserver &server;
+#ifdef MFEM_USE_GNUTLS
+   GnuTLS_session_params *params; // NULL: not secure
+   GnuTLS_resumption resumption;
+#endif
+
+   // connections accepted while collecting a session they are not part of
+   Array<ServerConnection *> pending;
+
+   // the parallel session being collected, shared by the accepting threads
+   pthread_mutex_t mutex;
+   pthread_cond_t cond;
+   Array<ServerConnection *> *session;
+   int nproc, first_rank; // session[i] is the connection of rank first_rank+i
+   int missing, in_flight;
+
+   // in aggregator mode, only a block of the ranks is accepted
+   int num_groups, group;
+
+   ServerConnection *Accept();
+   bool AddRank(ServerConnection *conn);
+   static void AcceptRanks(int, void *data);
+   void AcceptParallelSession(Array<ServerConnection *> &conns);
+
+public:
+#ifndef MFEM_USE_GNUTLS
+   ServerAcceptor(socketserver &_server);
+#else
+   ServerAcceptor(socketserver &_server, GnuTLS_session_params *_params);
+#endif
+
+   /// Accept only the ranks of aggregator 'group' of 'num_groups', see
+   /// GetAggregatorRanks().
+   void SetGroup(int _num_groups, int _group)
+   { num_groups = _num_groups; group = _group; }
+
+   /// Return the connections of the next session, ordered by rank.
+   void NextSession(Array<ServerConnection *> &conns);
+
+   /// Close the pending connections in a forked child process.
+   void ClosePending();
+
+   ~ServerAcceptor();
+};
+
+#ifndef MFEM_USE_GNUTLS
+ServerAcceptor::ServerAcceptor(socketserver &_server)
+   : server(_server), session(NULL), nproc(0), first_rank(0), missing(0),
+     in_flight(0), num_groups(1), group(0)
+#else
+ServerAcceptor::ServerAcceptor(socketserver &_server,
+                               GnuTLS_session_params *_params)
+   : server(_server), params(_params), session(NULL), nproc(0),
+     first_rank(0), missing(0), in_flight(0), num_groups(1), group(0)
+#endif
+{
+   pthread_mutex_init(&mutex, NULL);
+   pthread_cond_init(&cond, NULL);
+}
+
+ServerConnection *ServerAcceptor::Accept()
+{
+   ServerConnection *conn = new ServerConnection;
+#ifndef MFEM_USE_GNUTLS
+   conn->sock = new socketstream;
+#else
+   if (!params)
+   {
+      conn->sock = new socketstream(false);
+   }
+   else
+   {
+#ifdef MFEM_USE_GNUTLS_X509
+      conn->sock = new socketstream(
+         new GnuTLS_resumable_socketbuf(*params, resumption));
+#else
+      conn->sock = new socketstream(*params);
+#endif
+   }
+#endif
+   // with GnuTLS, the handshake is performed here
+   while (server.accept(*conn->sock) < 0)
+   {
+#ifdef GLVIS_DEBUG
+      cout << "GLVis: server.accept(...) failed." << endl;
+#endif
+   }
+   conn->input = OpenInputStream(conn->sock, conn->data_type);
+   conn->nproc = conn->proc = -1;
+   if (conn->data_type == "parallel")
+   {
+      *conn->input >> conn->nproc >> conn->proc;
+#ifdef GLVIS_DEBUG
+      cout << "new connection: parallel " << conn->nproc << ' '
+           << conn->proc << endl;
+#endif
+   }
+   return conn;
+}
+
+// Add 'conn' to the parallel session being collected, if it is a missing rank
+// of that session.
+bool ServerAcceptor::AddRank(ServerConnection *conn)
+{
+   Array<ServerConnection *> &s = *session;
+   const int i = conn->proc - first_rank;
+   if (conn->data_type != "parallel" || conn->nproc != nproc ||
+       i < 0 || i >= s.Size() || s[i])
+   {
+#ifdef GLVIS_DEBUG
+      cout << "GLVis: connection deferred to a later session." << endl;
+#endif
+      return false;
+   }
+   s[i] = conn;
+   missing--;
+   return true;
+}
+
+// Thread accepting connections until the parallel session is complete. A
+// thread only waits in accept() if that connection may still be needed.
+void ServerAcceptor::AcceptRanks(int, void *data)
+{
+   ServerAcceptor *acc = (ServerAcceptor *)data;
+
+   pthread_mutex_lock(&acc->mutex);
+   while (acc->missing > 0)
+   {
+      if (acc->in_flight >= acc->missing)
+      {
+         pthread_cond_wait(&acc->cond, &acc->mutex);
+         continue;
+      }
+      acc->in_flight++;
+      pthread_mutex_unlock(&acc->mutex);
+
+      ServerConnection *conn = acc->Accept();
+
+      pthread_mutex_lock(&acc->mutex);
+      acc->in_flight--;
+      if (!acc->AddRank(conn))
+      {
+         acc->pending.Append(conn);
+      }
+      pthread_cond_broadcast(&acc->cond);
+   }
+   pthread_mutex_unlock(&acc->mutex);
+}
+
+void ServerAcceptor::NextSession(Array<ServerConnection *> &conns)
+{
+   ServerConnection *first;
+   if (pending.Size() > 0)
+   {
+      first = pending[0];
+      pending.DeleteFirst(first);
+   }
+   else
+   {
+      first = Accept();
+   }
+   conns.SetSize(1);
+   conns[0] = first;
+   if (first->data_type == "parallel")
+   {
+      AcceptParallelSession(conns);
+   }
+#ifdef MFEM_USE_GNUTLS
+   resumption.PrintStats(cout);
+#endif
+}
+
+// Collect the other ranks of the parallel session started by conns[0].
+void ServerAcceptor::AcceptParallelSession(Array<ServerConnection *> &conns)
+{
+   ServerConnection *first = conns[0];
+   nproc = first->nproc;
+   if (nproc <= 0)
+   {
+      cout << "Invalid number of processors: " << nproc << endl;
+      mfem_error();
+   }
+   int end_rank;
+   GetAggregatorRanks(nproc, num_groups, group, first_rank, end_rank);
+   if (first_rank > first->proc || first->proc >= end_rank)
+   {
+      cout << "Invalid processor rank: " << first->proc
+           << ", number of processors: " << nproc;
+      if (num_groups > 1)
+      {
+         cout << ", ranks of this aggregator: [" << first_rank << ','
+              << end_rank << ')';
+      }
+      cout << endl;
+      mfem_error();
+   }
+   conns.SetSize(end_rank - first_rank);
+   conns = NULL;
+   conns[first->proc - first_rank] = first;
+   session = &conns;
+   missing = conns.Size() - 1;
+
+   // ranks that connected while the previous session was collected
+   int num_pending = 0;
+   for (int i = 0; i < pending.Size(); i++)
+   {
+      if (missing == 0 || !AddRank(pending[i]))
+      {
+         pending[num_pending++] = pending[i];
+      }
+   }
+   pending.SetSize(num_pending);
+
+   if (missing > 0)
+   {
+      // the handshakes mostly wait for the network, so use more threads than
+      // processors
+      int max_threads = 4*GetNumWorkerThreads();
+      if (missing < max_threads) { max_threads = missing; }
+      in_flight = 0;
+      ParallelFor(max_threads, AcceptRanks, this, max_threads);
+   }
+   session = NULL;
+}
+
+void ServerAcceptor::ClosePending()
+{
+   for (int i = 0; i < pending.Size(); i++)
+   {
+      pending[i]->sock->rdbuf()->socketbuf::close();
+   }
+}
+
+ServerAcceptor::~ServerAcceptor()
+{
+   for (int i = 0; i < pending.Size(); i++)
+   {
+      delete pending[i]->input; // a decompressing stream owns the socket
+      delete pending[i];
+   }
+   pthread_cond_destroy(&cond);
+   pthread_mutex_destroy(&mutex);
+}
+
+// Start a warm worker process, which prepares the visualization and then waits
+// for a session from the server. Returns true on success.
+static bool StartWarmWorker(socketserver &server, ServerAcceptor &acceptor,
+                            Array<int> &channels, Array<int> &pids)
+{
+   int sv[2];
+   if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+   {
+      perror("socketpair()");
+      return false;
+   }
+   const int pid = fork();
+   if (pid == -1)
+   {
+      close(sv[0]);
+      close(sv[1]);
+      return false;
+   }
+   if (pid > 0)
+   {
+      close(sv[1]);
+      channels.Append(sv[0]);
+      pids.Append(pid);
+      return true;
+   }
+
+   // the worker process
+   server.close();
+   acceptor.ClosePending();
+   close(sv[0]);
+   for (int i = 0; i < channels.Size(); i++)
+   {
+      close(channels[i]);
+   }
+   signal(SIGINT, SIG_IGN);
+   if (PrepareVisualization())
+   {
+      exit(1);
+   }
+
+   string data_type;
+   if (ReceiveSession(sv[1], data_type, input_streams))
+   {
+      exit(0); // the server exited
+   }
+   close(sv[1]);
+   int ft;
+   if (data_type == "parallel")
+   {
+      ft = ReadInputStreams();
+   }
+   else
+   {
+      ft = ReadStream(*input_streams[0], data_type);
+   }
+   StartVisualization(ft);
+   CloseInputStreams(false);
+   exit(0);
+}
+
+// Hand the session to a warm worker. Returns the pid of the worker, or -1 if
+// no worker could take the session.
+static int SendToWarmWorker(Array<int> &channels, Array<int> &pids,
+                            const string &data_type, Array<istream *> &streams)
+{
+   if (!CanSendSession(streams))
+   {
+      return -1;
+   }
+   while (channels.Size() > 0)
+   {
+      const int channel = channels.Last(), pid = pids.Last();
+      channels.DeleteLast();
+      pids.DeleteLast();
+      const int err = SendSession(channel, data_type, streams);
+      close(channel);
+      if (!err)
+      {
+         return pid;
+      }
+      // the worker exited, e.g. it could not open the display
+   }
+   return -1;
+}
+
+int main (int argc, char *argv[])
+{
+   // variables for command line arguments
+   bool        multi_session = true;   // not added as option
+   bool        mac           = false;
+   const char *stream_file   = string_none;
+   const char *script_file   = string_none;
+   const char *font_name     = string_default;
+   int         portnum       = 19916;
+   bool        secure        = socketstream::secure_default;
+   int         multisample   = GetMultisample();
+   double      line_width    = Get_LineWidth();
+   double      ms_line_width = Get_MS_LineWidth();
+   int         geom_ref_type = Quadrature1D::ClosedUniform;
+   const char *agg_host      = string_none;
+   int         agg_port      = 19916;
+   int         agg_groups    = 1;
+   int         agg_group     = 0;
+   int         warm_pool     = 0;
+   const char *cache_dir     = string_none;
+   int         mesh_cache_mb = 0;
+   int         shared_mb     = 0;
+   int         history_len   = 0;
+   const char *history_codec = "none";
+   double      history_fps   = 10.0;
+   const char *seq_pattern   = string_none;
+   int         seq_first     = 0;
+   int         seq_last      = -1;
+   int         seq_step      = 1;
+   int         seq_cache     = seq_default_cache;
 
    OptionsParser args(argc, argv);
 
@@ -1155,6 +1951,21 @@ int main (int argc, char *argv[])
    args.AddOption(&gf_component, "-gc", "--grid-function-component",
                   "Select a grid function component, [0-<num-comp>) or"
                   " -1 for all.");
+   args.AddOption(&seq_pattern, "-gs", "--grid-function-sequence",
+                  "Play back the solution files named with a printf-style"
+                  " pattern, e.g. sol.%06d.gf, on the mesh given with -m.");
+   args.AddOption(&seq_first, "-gsf", "--sequence-first",
+                  "Number of the first file of the -gs sequence.");
+   args.AddOption(&seq_last, "-gsl", "--sequence-last",
+                  "Number of the last file of the -gs sequence, or -1 for all"
+                  " files up to the first missing one.");
+   args.AddOption(&seq_step, "-gss", "--sequence-step",
+                  "Step between the numbers of the -gs files.");
+   args.AddOption(&seq_fps, "-gsfps", "--sequence-fps",
+                  "Frames per second in the playback of the -gs sequence.");
+   args.AddOption(&seq_cache, "-gsc", "--sequence-cache",
+                  "Number of -gs solutions kept in memory; half of them are"
+                  " read ahead.");
    args.AddOption(&sol_file, "-s", "--scalar-solution",
                   "Scalar solution (vertex values) file to visualize.");
    args.AddOption(&vec_sol_file, "-v", "--vector-solution",
@@ -1189,6 +2000,37 @@ int main (int argc, char *argv[])
                   "-no-mac", "--dont-save-stream",
                   "In server mode, save incoming data to a file before"
                   " visualization.");
+   args.AddOption(&warm_pool, "-wp", "--warm-pool",
+                  "In server mode, number of worker processes to start in"
+                  " advance, with the display and the font initialized.");
+   args.AddOption(&agg_host, "-agg", "--aggregate",
+                  "Run as an aggregator: merge the pieces of a block of the"
+                  " ranks of parallel sessions and send them to this host.");
+   args.AddOption(&agg_port, "-aggp", "--aggregate-port",
+                  "Port of the GLVis server (or aggregator) to send to.");
+   args.AddOption(&agg_groups, "-aggn", "--aggregate-num-groups",
+                  "Number of aggregators the ranks are distributed to.");
+   args.AddOption(&agg_group, "-aggi", "--aggregate-group",
+                  "Index of this aggregator: it accepts the ranks p with"
+                  " p*<num-groups>/<num-ranks> == <index>.");
+   args.AddOption(&cache_dir, "-cache", "--file-cache",
+                  "Directory for caching the meshes and solutions loaded with"
+                  " -m and -g in binary form, for faster reloading.");
+   args.AddOption(&mesh_cache_mb, "-mcache", "--mesh-cache",
+                  "Size in MB of the cache of parsed meshes received through"
+                  " sockets or read by scripts, or 0 to disable it.");
+   args.AddOption(&shared_mb, "-sm", "--shared-meshes",
+                  "Size in MB of the meshes of serial sessions that the server"
+                  " reads and keeps, so that the sessions with the same mesh"
+                  " share its memory, or 0 to disable this.");
+   args.AddOption(&history_len, "-hist", "--history",
+                  "Number of stream solutions on the same mesh to keep for"
+                  " stepping back (PageUp/PageDown/End) and playback (Home).");
+   args.AddOption(&history_codec, "-histc", "--history-codec",
+                  "Storage of the kept solutions: none, float (lossy) or zlib"
+                  " (lossless).");
+   args.AddOption(&history_fps, "-hfps", "--history-fps",
+                  "Frames per second in the playback of the kept solutions.");
    args.AddOption(&stream_file, "-saved", "--saved-stream",
                   "Load a GLVis stream saved to a file.");
    args.AddOption(&window_w, "-ww", "--window-width",
@@ -1248,6 +2090,26 @@ int main (int argc, char *argv[])
       sol_file = gfunc_file;
       is_gf = 255;
    }
+   string seq_first_file;
+   if (seq_pattern != string_none)
+   {
+      if (mesh_file == string_none || np > 0 || gf_component != -1)
+      {
+         cout << "The -gs option needs a serial mesh (-m) and all the"
+              << " components of the solutions." << endl;
+         return 1;
+      }
+      if (!SolutionSequence::IsPattern(seq_pattern))
+      {
+         cout << "The -gs pattern needs exactly one integer conversion, e.g."
+              << " %06d, and no other '%' (except %%): " << seq_pattern
+              << endl;
+         return 1;
+      }
+      seq_first_file = SolutionSequence::FileName(seq_pattern, seq_first);
+      sol_file = seq_first_file.c_str();
+      is_gf = 255;
+   }
    if (np > 0)
    {
       input |= 256;
@@ -1256,6 +2118,19 @@ int main (int argc, char *argv[])
    {
       keys = arg_keys;
    }
+   if (cache_dir != string_none)
+   {
+      SetFileCacheDir(cache_dir);
+   }
+   if (mesh_cache_mb > 0)
+   {
+      SetMeshCacheSize(size_t(mesh_cache_mb) << 20);
+   }
+   if (!SetSolutionHistory(history_len, history_codec, history_fps))
+   {
+      cout << "Unknown history codec: " << history_codec << endl;
+      return 1;
+   }
    if (font_name != string_default)
    {
       SetFont(font_name);
@@ -1328,8 +2203,16 @@ int main (int argc, char *argv[])
       return 1;
    }
 #endif
+   if (agg_host != string_none &&
+       (input != 1 || agg_groups < 1 || agg_group < 0 ||
+        agg_group >= agg_groups))
+   {
+      cout << "Invalid aggregator options: aggregator " << agg_group
+           << " of " << agg_groups << " (only in server mode)." << endl;
+      return 1;
+   }
 
-   int childPID, viscount = 0, nproc = 1, proc = 0;
+   int childPID, viscount = 0;
 
    // server mode, read the mesh and the solution from a socket
    if (input == 1)
@@ -1345,6 +2228,7 @@ int main (int argc, char *argv[])
       GnuTLS_session_params *params = NULL;
       if (secure)
       {
+         AllowControlConnections(false);
          state = new GnuTLS_global_state;
          // state->set_log_level(1000);
          string home_dir(getenv("HOME"));
@@ -1391,22 +2275,73 @@ int main (int argc, char *argv[])
          return 2;
       }
 
-      socketstream *isock;
 #ifndef MFEM_USE_GNUTLS
-      isock = new socketstream;
+      ServerAcceptor acceptor(server);
 #else
-      isock = secure ? new socketstream(*params) : new socketstream(false);
+      ServerAcceptor acceptor(server, params);
 #endif
-      while (1)
+      Array<ServerConnection *> session;
+      if (agg_host != string_none)
+      {
+         acceptor.SetGroup(agg_groups, agg_group);
+      }
+      while (agg_host != string_none)
       {
-         while (server.accept(*isock) < 0)
+         acceptor.NextSession(session);
+         if (session[0]->data_type == "parallel")
          {
-#ifdef GLVIS_DEBUG
-            cout << "GLVis: server.accept(...) failed." << endl;
-#endif
+            Array<istream *> streams(session.Size());
+            for (int i = 0; i < session.Size(); i++)
+            {
+               streams[i] = session[i]->input;
+            }
+            AggregateParallelSession(streams, session[0]->nproc,
+                                     session[0]->proc, agg_host, agg_port,
+                                     agg_groups, agg_group, fix_elem_orient,
+                                     keep_attr);
+         }
+         else
+         {
+            cout << "Aggregator: not a parallel session: "
+                 << session[0]->data_type << endl;
+         }
+         for (int i = 0; i < session.Size(); i++)
+         {
+            delete session[i]->input; // also deletes the socket stream
+            delete session[i];
          }
+      }
+      // compute the data shared by all sessions once, before they are forked
+      if (multi_session)
+      {
+         PrepareSharedVisualizationData();
+      }
+      // the meshes are read by the server and kept in its mesh cache, see
+      // ReadSharedMesh()
+      const bool shared_meshes = (shared_mb > 0 && multi_session && !mac);
+      if (shared_meshes)
+      {
+         SetMeshCacheSize(size_t(shared_mb) << 20);
+      }
+      Array<int> warm_channels, warm_pids;
+      if (warm_pool > 0 && (!multi_session || mac || secure || shared_meshes))
+      {
+         cout << "The warm pool is not used with secure sockets, -mac or -sm."
+              << endl;
+         warm_pool = 0;
+      }
+      while (1)
+      {
+         while (warm_channels.Size() < warm_pool &&
+                StartWarmWorker(server, acceptor, warm_channels, warm_pids))
+         { }
+
+         acceptor.NextSession(session);
 
-         *isock >> data_type >> ws;
+         // stream to read the data from: isock or a decompressing stream
+         socketstream *isock = session[0]->sock;
+         istream *input = session[0]->input;
+         data_type = session[0]->data_type;
 
          if (mac)
          {
@@ -1417,74 +2352,22 @@ int main (int argc, char *argv[])
          if (data_type == "parallel")
          {
             par_data = 1;
-            np = 0;
-            do
+            input_streams.SetSize(session.Size());
+            for (int i = 0; i < session.Size(); i++)
             {
-               *isock >> nproc >> proc;
-#ifdef GLVIS_DEBUG
-               cout << "new connection: parallel " << nproc << ' ' << proc
-                    << endl;
-#endif
-               if (np == 0)
-               {
-                  if (nproc <= 0)
-                  {
-                     cout << "Invalid number of processors: " << nproc << endl;
-                     mfem_error();
-                  }
-                  input_streams.SetSize(nproc);
-                  input_streams = NULL;
-               }
-               else
-               {
-                  if (nproc != input_streams.Size())
-                  {
-                     cout << "Unexpected number of processors: " << nproc
-                          << ", expected: " << input_streams.Size() << endl;
-                     mfem_error();
-                  }
-               }
-               if (0 > proc || proc >= nproc)
-               {
-                  cout << "Invalid processor rank: " << proc
-                       << ", number of processors: " << nproc << endl;
-                  mfem_error();
-               }
-               if (input_streams[proc])
-               {
-                  cout << "Second connection attempt from processor rank: "
-                       << proc << endl;
-                  mfem_error();
-               }
-
-               input_streams[proc] = isock;
-#ifndef MFEM_USE_GNUTLS
-               isock = new socketstream;
-#else
-               isock = secure ? new socketstream(*params) :
-                       new socketstream(false);
-#endif
-               np++;
-               if (np == nproc)
-               {
-                  break;
-               }
-               // read next available socket stream
-               while (server.accept(*isock) < 0)
-               {
-#ifdef GLVIS_DEBUG
-                  cout << "GLVis: server.accept(...) failed." << endl;
-#endif
-               }
-               *isock >> data_type >> ws; // "parallel"
-               if (data_type != "parallel")
-               {
-                  cout << "Expected keyword \"parallel\", got \"" << data_type
-                       << '"' << endl;
-                  mfem_error();
-               }
+               input_streams[i] = session[i]->input;
             }
-            while (1);
+         }
+         for (int i = 0; i < session.Size(); i++)
+         {
+            delete session[i];
+         }
+
+         // read the mesh before forking, so that the sessions share it
+         bool shared_mesh = false;
+         if (shared_meshes && (data_type == "solution" || data_type == "mesh"))
+         {
+            session_mesh = ReadSharedMesh(*input, fix_elem_orient, shared_mesh);
          }
 
          char tmp_file[50];
@@ -1497,7 +2380,7 @@ int main (int argc, char *argv[])
                if (!par_data)
                {
                   ofs << data_type << '\n';
-                  ofs << isock->rdbuf();
+                  ofs << input->rdbuf();
                   isock->close();
                }
                else
@@ -1514,7 +2397,25 @@ int main (int argc, char *argv[])
                ofs.close();
                cout << "Data saved in " << tmp_file << endl;
             }
-            childPID = fork();
+            childPID = -1;
+            if (warm_channels.Size() > 0)
+            {
+               Array<istream *> streams;
+               if (par_data)
+               {
+                  input_streams.Copy(streams);
+               }
+               else
+               {
+                  streams.Append(input);
+               }
+               childPID = SendToWarmWorker(warm_channels, warm_pids,
+                                           data_type, streams);
+            }
+            if (childPID == -1)
+            {
+               childPID = fork();
+            }
          }
          else
          {
@@ -1529,6 +2430,18 @@ int main (int argc, char *argv[])
 
             case 0:                       // This is the child process
                server.close();
+               acceptor.ClosePending();
+               for (int i = 0; i < warm_channels.Size(); i++)
+               {
+                  close(warm_channels[i]);
+               }
+               if (shared_meshes)
+               {
+                  // this process owns its copy of session_mesh, the other
+                  // meshes are not used
+                  ForgetMeshCache();
+                  SetMeshCacheSize(size_t(mesh_cache_mb) << 20);
+               }
                if (mac)
                {
                   // exec ourself
@@ -1545,12 +2458,11 @@ int main (int argc, char *argv[])
                   int ft;
                   if (!par_data)
                   {
-                     ft = ReadStream(*isock, data_type);
-                     input_streams.Append(isock);
+                     ft = ReadStream(*input, data_type);
+                     input_streams.Append(input);
                   }
                   else
                   {
-                     delete isock;
                      ft = ReadInputStreams();
                   }
                   StartVisualization(ft);
@@ -1559,9 +2471,15 @@ int main (int argc, char *argv[])
                }
 
             default :                     // This is the parent process
+               if (!shared_mesh)
+               {
+                  delete session_mesh;
+               }
+               session_mesh = NULL;
                if (!par_data)
                {
                   isock->rdbuf()->socketbuf::close();
+                  delete input; // a decompressing stream also deletes isock
                }
                else
                {
@@ -1586,7 +2504,38 @@ int main (int argc, char *argv[])
 
       int window_err;
       double mesh_range = -1.0;
-      if (mesh->SpaceDimension() == 2)
+      if (mesh->SpaceDimension() == 1)
+      {
+         // scalar solutions on 1D meshes, see Extrude1DMeshAndSolution()
+         VisualizationSceneSolution1d *vss;
+         window_err = InitVis((input & 4) ? 0 : 2);
+         if (!window_err)
+         {
+            if ((input & 4) == 0)
+            {
+               Set_Palette(4);
+            }
+            vs = vss = new VisualizationSceneSolution1d(*mesh, sol);
+            if (is_gf)
+            {
+               vss->SetGridFunction(*grid_f);
+            }
+            if ((input & 4) == 0)
+            {
+               vss->ToggleDrawAxes();
+               vss->ToggleDrawMesh();
+               if (grid_f)
+               {
+                  mesh_range = grid_f->Max() + 1.0;
+               }
+               else
+               {
+                  mesh_range = sol.Max() + 1.0;
+               }
+            }
+         }
+      }
+      else if (mesh->SpaceDimension() == 2)
       {
          if ((input & 8) == 0)
          {
@@ -1703,7 +2652,13 @@ int main (int argc, char *argv[])
             vs->SetValueRange(-mesh_range, mesh_range);
             vs->SetAutoscale(0);
          }
-         if (mesh->SpaceDimension() == 2 && (input & 12) == 0)
+         if (seq_pattern != string_none)
+         {
+            StartSequence(seq_pattern, seq_first, seq_last, seq_step,
+                          seq_cache);
+         }
+         if (mesh->SpaceDimension() == 1 ||
+             (mesh->SpaceDimension() == 2 && (input & 12) == 0))
          {
             SetVisualizationScene(vs, 2, keys.c_str());
          }
@@ -1713,6 +2668,7 @@ int main (int argc, char *argv[])
          }
          KillVisualization(); // deletes vs
          if (is_gf) { delete grid_f; }
+         StopSequence();
          delete mesh;
       }
       else
@@ -1743,30 +2699,31 @@ void PrintSampleUsage(ostream &out)
 }
 
 
-void ReadSerial()
+// Read the mesh and the solution from the files given on the command line
+static void ReadSerialFiles()
 {
    // get the mesh from a file
-   ifgzstream meshin(mesh_file);
+   ifpgzstream meshin(mesh_file);
    if (!meshin)
    {
       cerr << "Can not open mesh file " << mesh_file << ". Exit.\n";
       exit(1);
    }
 
-   mesh = new Mesh(meshin, 1, 0, fix_elem_orient);
+   mesh = ReadMesh(meshin, fix_elem_orient);
 
    if (is_gf || (input & 4) || (input & 8))
    {
       // get the solution from file
       bool freesolin = false;
-      ifgzstream *solin = NULL;
+      istream *solin = NULL;
       if (!strcmp(mesh_file,sol_file))
       {
          solin = &meshin;
       }
       else
       {
-         solin = new ifgzstream(sol_file);
+         solin = new ifpgzstream(sol_file);
          freesolin = true;
          if (!(*solin))
          {
@@ -1775,25 +2732,41 @@ void ReadSerial()
          }
       }
 
+      // uncompressed files are memory-mapped and their values are parsed
+      // concurrently; the stream is used if that fails
+      MappedInput msol(sol_file, (solin == &meshin) ?
+                       long(streamoff(meshin.tellg())) : 0L);
+      const int nv = mesh->GetNV();
       if (is_gf)
       {
-         grid_f = new GridFunction(mesh, *solin);
-         SetGridFunction();
+         grid_f = msol.LoadGridFunction(mesh);
+         if (!grid_f)
+         {
+            grid_f = ReadGridFunction(mesh, *solin);
+         }
       }
       else if (input & 4)
       {
-         // get rid of NetGen's info line
-         char buff[128];
-         solin->getline(buff,128);
-         sol.Load(*solin, mesh->GetNV());
+         if (!(msol.SkipLine() && msol.LoadVector(sol, nv)))
+         {
+            // get rid of NetGen's info line
+            char buff[128];
+            solin->getline(buff,128);
+            sol.Load(*solin, nv);
+         }
       }
       else if (input & 8)
       {
-         solu.Load(*solin, mesh->GetNV());
-         solv.Load(*solin, mesh->GetNV());
-         if (mesh->SpaceDimension() == 3)
+         const bool dim3 = (mesh->SpaceDimension() == 3);
+         if (!(msol.LoadVector(solu, nv) && msol.LoadVector(solv, nv) &&
+               (!dim3 || msol.LoadVector(solw, nv))))
          {
-            solw.Load(*solin, mesh->GetNV());
+            solu.Load(*solin, nv);
+            solv.Load(*solin, nv);
+            if (dim3)
+            {
+               solw.Load(*solin, nv);
+            }
          }
       }
       if (freesolin)
@@ -1801,12 +2774,35 @@ void ReadSerial()
          delete solin;
       }
    }
-   else
+}
+
+void ReadSerial()
+{
+   // meshes and grid functions (not the vertex values of -s and -v) are read
+   // from the file cache, when enabled with -cache and up to date
+   const bool vertex_values = (input & 4) || (input & 8);
+   const char *cache_sol_file = is_gf ? sol_file : NULL;
+   if (vertex_values || !LoadFromFileCache(mesh_file, cache_sol_file,
+                                        fix_elem_orient, &mesh, &grid_f))
+   {
+      ReadSerialFiles();
+      if (!vertex_values)
+      {
+         SaveToFileCache(mesh_file, cache_sol_file, fix_elem_orient, *mesh,
+                         grid_f);
+      }
+   }
+
+   if (is_gf)
+   {
+      SetGridFunction();
+   }
+   else if (!vertex_values)
    {
       SetMeshSolution(mesh, grid_f, save_coloring);
    }
 
-   Extrude1DMeshAndSolution(&mesh, &grid_f, &sol);
+   input_mesh_1d = Extrude1DMeshAndSolution(&mesh, &grid_f, &sol);
 }
 
 
@@ -1820,8 +2816,7 @@ void SetGridFunction()
          exit(1);
       }
       FiniteElementSpace *ofes = grid_f->FESpace();
-      FiniteElementCollection *fec =
-         FiniteElementCollection::New(ofes->FEColl()->Name());
+      FiniteElementCollection *fec = NewFECollection(ofes->FEColl()->Name());
       FiniteElementSpace *fes = new FiniteElementSpace(mesh, fec);
       GridFunction *new_gf = new GridFunction(fes);
       new_gf->MakeOwner(fec);
@@ -1851,7 +2846,8 @@ void SetMeshSolution(Mesh *mesh, GridFunction *&grid_f, bool save_coloring)
       FiniteElementCollection *cfec;
       if (mesh->Dimension() == 1)
       {
-         cfec = new L2_FECollection(0, 1);
+         // L2_FECollection(0, 1), see NewFECollection()
+         cfec = NewFECollection("L2_1D_P0");
       }
       else if (mesh->Dimension() == 2)
       {
@@ -1925,145 +2921,206 @@ void ReadParallel()
       exit(1);
    }
 
-   Extrude1DMeshAndSolution(&mesh, &grid_f, &sol);
+   input_mesh_1d = Extrude1DMeshAndSolution(&mesh, &grid_f, &sol);
 }
 
-int ReadParMeshAndGridFunction(int np, const char *mesh_prefix,
-                               const char *sol_prefix, Mesh **mesh_p,
-                               GridFunction **sol_p, int keep_attr)
+// Data shared by the tasks reading the pieces in ReadParMeshAndGridFunction()
+struct ParFilesData
 {
+   const char *mesh_prefix, *sol_prefix; // sol_prefix is NULL for meshes only
+   int keep_attr;
    Array<Mesh *> mesh_array;
-   Array<named_ifgzstream *> meshfiles;
+   Array<GridFunction *> gf_array;
+   int mesh_error, sol_error; // a mesh/solution file could not be opened
+};
 
-   mesh_array.SetSize(np);
-   meshfiles.SetSize(np);
-   for (int p = 0; p < np; p++)
+// Read the mesh and the solution of piece p
+static void ReadParFiles(int p, void *data)
+{
+   ParFilesData &pd = *(ParFilesData *)data;
+   if (__atomic_load_n(&pd.mesh_error, __ATOMIC_RELAXED) ||
+       __atomic_load_n(&pd.sol_error, __ATOMIC_RELAXED))
    {
-      ostringstream fname;
-      fname << mesh_prefix << '.' << setfill('0') << setw(pad_digits) << p;
-      meshfiles[p] = new named_ifgzstream(fname.str().c_str());
-      if (!(*meshfiles[p]))
+      return; // the pieces will not be used
+   }
+   ostringstream fname;
+   fname << pd.mesh_prefix << '.' << setfill('0') << setw(pad_digits) << p;
+   named_ifgzstream meshfile(fname.str().c_str());
+   if (!meshfile)
+   {
+      cerr << "Can not open mesh file: " << fname.str().c_str()
+           << '!' << endl;
+      __atomic_store_n(&pd.mesh_error, 1, __ATOMIC_RELAXED);
+      return;
+   }
+   // read the whole file before parsing it: curved meshes are parsed one at a
+   // time (see ReadMesh), without waiting for the file system meanwhile
+   ostringstream text;
+   text << meshfile.rdbuf();
+   istringstream meshtext(text.str());
+   Mesh *m = ReadMesh(meshtext, fix_elem_orient);
+   pd.mesh_array[p] = m;
+   if (!pd.keep_attr)
+   {
+      // set element and boundary attributes to be the processor number + 1
+      for (int i = 0; i < m->GetNE(); i++)
       {
-         cerr << "Can not open mesh file: " << fname.str().c_str()
-              << '!' << endl;
-         for (p--; p >= 0; p--)
-         {
-            delete mesh_array[p];
-            delete meshfiles[p];
-         }
-         return 1;
+         m->GetElement(i)->SetAttribute(p+1);
       }
-      mesh_array[p] = new Mesh(*meshfiles[p], 1, 0, fix_elem_orient);
-      if (!keep_attr)
+      for (int i = 0; i < m->GetNBE(); i++)
       {
-         // set element and boundary attributes to be the processor number + 1
-         for (int i = 0; i < mesh_array[p]->GetNE(); i++)
-         {
-            mesh_array[p]->GetElement(i)->SetAttribute(p+1);
-         }
-         for (int i = 0; i < mesh_array[p]->GetNBE(); i++)
-         {
-            mesh_array[p]->GetBdrElement(i)->SetAttribute(p+1);
-         }
+         m->GetBdrElement(i)->SetAttribute(p+1);
       }
    }
-   *mesh_p = new Mesh(mesh_array, np);
 
-   if (sol_prefix && sol_p)
+   if (pd.sol_prefix == NULL)
    {
-      Array<GridFunction *> gf_array(np);
-      bool samefile = !strcmp(sol_prefix,mesh_prefix);
-      for (int p = 0; p < np; p++)
-      {
-         if (!samefile)
-         {
-            ostringstream fname;
-            fname << sol_prefix << '.' << setfill('0') << setw(pad_digits) << p;
-            ifgzstream solfile(fname.str().c_str());
-            if (!solfile)
-            {
-               cerr << "Can not open solution file " << fname.str().c_str()
-                    << '!' << endl;
-               for (p--; p >= 0; p--)
-               {
-                  delete gf_array[p];
-               }
-               delete *mesh_p;
-               *mesh_p = NULL;
-               for (p = 0; p < np; p++)
-               {
-                  delete mesh_array[np-1-p];
-                  delete meshfiles[np-1-p];
-               }
-               return 2;
-            }
-            gf_array[p] = new GridFunction(mesh_array[p], solfile);
-         }
-         else  // mesh and solution in the same file
-         {
-            gf_array[p] = new GridFunction(mesh_array[p], *meshfiles[p]);
-         }
-      }
-      *sol_p = new GridFunction(*mesh_p, gf_array, np);
+      return;
+   }
+   if (!strcmp(pd.sol_prefix, pd.mesh_prefix))
+   {
+      // mesh and solution in the same file
+      pd.gf_array[p] = ReadGridFunction(pd.mesh_array[p], meshtext);
+      return;
+   }
+   fname.str("");
+   fname << pd.sol_prefix << '.' << setfill('0') << setw(pad_digits) << p;
+   ifpgzstream solfile(fname.str().c_str());
+   if (!solfile)
+   {
+      cerr << "Can not open solution file " << fname.str().c_str()
+           << '!' << endl;
+      __atomic_store_n(&pd.sol_error, 1, __ATOMIC_RELAXED);
+      return;
+   }
+   pd.gf_array[p] = ReadGridFunction(pd.mesh_array[p], solfile);
+}
 
-      for (int p = 0; p < np; p++)
+int ReadParMeshAndGridFunction(int np, const char *mesh_prefix,
+                               const char *sol_prefix, Mesh **mesh_p,
+                               GridFunction **sol_p, int keep_attr)
+{
+   ParFilesData pd;
+   pd.mesh_prefix = mesh_prefix;
+   pd.sol_prefix = sol_p ? sol_prefix : NULL;
+   pd.keep_attr = keep_attr;
+   pd.mesh_array.SetSize(np);
+   pd.mesh_array = NULL;
+   pd.gf_array.SetSize(np);
+   pd.gf_array = NULL;
+   pd.mesh_error = pd.sol_error = 0;
+
+   // read the pieces concurrently; with many pieces on a parallel file
+   // system, the time is mostly spent waiting for the files to be opened and
+   // read, so use more threads than processors. The construction of the finite
+   // element collections is serialized by ReadMesh/ReadGridFunction.
+   ParallelFor(np, ReadParFiles, &pd, 4*GetNumWorkerThreads());
+
+   const int err = pd.mesh_error ? 1 : (pd.sol_error ? 2 : 0);
+   if (err)
+   {
+      for (int p = np-1; p >= 0; p--)
       {
-         delete gf_array[np-1-p];
+         delete pd.gf_array[p];
+         delete pd.mesh_array[p];
       }
+      return err;
+   }
+
+   // the pieces are merged in the order of the ranks
+   *mesh_p = new Mesh(pd.mesh_array, np);
+   if (pd.sol_prefix)
+   {
+      *sol_p = MergeGridFunctionPieces(*mesh_p, pd.gf_array);
    }
 
    for (int p = 0; p < np; p++)
    {
-      delete mesh_array[np-1-p];
-      delete meshfiles[np-1-p];
+      delete pd.mesh_array[np-1-p];
    }
 
    return 0;
 }
 
-int ReadInputStreams()
+// Data shared by the tasks reading the initial pieces in ReadInputStreams()
+struct InputStreamsData
 {
-   int nproc = input_streams.Size();
-   Array<Mesh *> mesh_array(nproc);
-   Array<GridFunction *> gf_array(nproc);
-   string data_type;
-
-   int gf_count = 0;
-   int field_type = 0;
+   Array<Mesh *> mesh_array;
+   Array<GridFunction *> gf_array;
+};
 
-   for (int p = 0; p < nproc; p++)
-   {
+// Read the initial mesh and solution sent by rank p
+void ReadInputStream(int p, void *data)
+{
+   InputStreamsData &isd = *(InputStreamsData *)data;
+   string data_type;
 #ifdef GLVIS_DEBUG
-      cout << "connection[" << p << "]: reading initial data ... " << flush;
+   cout << "connection[" << p << "]: reading initial data ..." << endl;
 #endif
-      istream &isock = *input_streams[p];
-      // assuming the "parallel nproc p" part of the stream has been read
-      isock >> ws >> data_type >> ws; // "*_data" / "mesh" / "solution"
+   istream &isock = *input_streams[p];
+   // assuming the "parallel nproc p" part of the stream has been read
+   // "*_data" / "mesh" / "solution" / "binary" / "shm"
+   isock >> ws >> data_type >> ws;
 #ifdef GLVIS_DEBUG
-      cout << " type " << data_type << " ... " << flush;
+   cout << "connection[" << p << "]: type " << data_type << endl;
 #endif
-      mesh_array[p] = new Mesh(isock, 1, 0, fix_elem_orient);
-      if (!keep_attr)
+   Mesh *m;
+   GridFunction *g = NULL;
+   if (IsBinaryDataType(data_type))
+   {
+      if (ReadBinaryData(data_type, isock, &m, &g, fix_elem_orient))
       {
-         // set element and boundary attributes to proc+1
-         for (int i = 0; i < mesh_array[p]->GetNE(); i++)
-         {
-            mesh_array[p]->GetElement(i)->SetAttribute(p+1);
-         }
-         for (int i = 0; i < mesh_array[p]->GetNBE(); i++)
-         {
-            mesh_array[p]->GetBdrElement(i)->SetAttribute(p+1);
-         }
+         mfem_error("Invalid binary data in input stream!");
+      }
+   }
+   else
+   {
+      m = ReadMesh(isock, fix_elem_orient);
+   }
+   if (!keep_attr)
+   {
+      // set element and boundary attributes to proc+1
+      for (int i = 0; i < m->GetNE(); i++)
+      {
+         m->GetElement(i)->SetAttribute(p+1);
       }
-      gf_array[p] = NULL;
-      if (data_type != "mesh")
+      for (int i = 0; i < m->GetNBE(); i++)
       {
-         gf_array[p] = new GridFunction(mesh_array[p], isock);
-         gf_count++;
+         m->GetBdrElement(i)->SetAttribute(p+1);
       }
+   }
+   isd.mesh_array[p] = m;
+   if (g)
+   {
+      isd.gf_array[p] = g;
+   }
+   else if (data_type != "mesh" && !IsBinaryDataType(data_type))
+   {
+      isd.gf_array[p] = ReadGridFunction(isd.mesh_array[p], isock);
+   }
 #ifdef GLVIS_DEBUG
-      cout << "done." << endl;
+   cout << "connection[" << p << "]: done." << endl;
 #endif
+}
+
+int ReadInputStreams()
+{
+   int nproc = input_streams.Size();
+   InputStreamsData isd;
+   Array<Mesh *> &mesh_array = isd.mesh_array;
+   Array<GridFunction *> &gf_array = isd.gf_array;
+   mesh_array.SetSize(nproc);
+   gf_array.SetSize(nproc);
+   gf_array = NULL;
+
+   int gf_count = 0;
+   int field_type = 0;
+
+   // parse the pieces from all ranks concurrently
+   ParallelFor(nproc, ReadInputStream, &isd);
+   for (int p = 0; p < nproc; p++)
+   {
+      if (gf_array[p]) { gf_count++; }
    }
 
    if (gf_count > 0 && gf_count != nproc)
@@ -2079,66 +3136,79 @@ int ReadInputStreams()
    }
    else
    {
-      grid_f = new GridFunction(mesh, gf_array, nproc);
+      grid_f = MergeGridFunctionPieces(mesh, gf_array, false);
       field_type = (grid_f->VectorDim() == 1) ? 0 : 1;
    }
 
-   for (int p = 0; p < nproc; p++)
-   {
-      delete mesh_array[nproc-1-p];
-      delete gf_array[nproc-1-p];
-   }
+   // keep the pieces for the incremental updates
+   mesh_array.Copy(input_mesh_pieces);
+   gf_array.Copy(input_gf_pieces);
 
-   Extrude1DMeshAndSolution(&mesh, &grid_f, NULL);
+   input_mesh_1d = Extrude1DMeshAndSolution(&mesh, &grid_f, NULL);
 
    return field_type;
 }
 
+// Read the data type keyword from a newly accepted connection. If the client
+// requested compression, the data type and all following data are read through
+// a decompressing stream (which owns 'isock') that is returned instead of isock.
+istream *OpenInputStream(socketstream *isock, string &data_type)
+{
+   *isock >> data_type;
+   if (data_type != "compressed")
+   {
+      *isock >> ws;
+      return isock;
+   }
+   string codec;
+   *isock >> codec;
+   if (isock->get() != '\n' || !ZStreamCodecSupported(codec))
+   {
+      cout << "Unsupported stream compression: " << codec << endl;
+      return isock;
+   }
+   istream *zin = new izstream(isock, true);
+   *zin >> data_type >> ws;
+   return zin;
+}
+
 void CloseInputStreams(bool parent)
 {
    for (int i = 0; i < input_streams.Size(); i++)
    {
       if (parent)
       {
-         socketstream *sock = dynamic_cast<socketstream*>(input_streams[i]);
+         socketstream *sock = GetSocketStream(input_streams[i]);
          if (sock) { sock->rdbuf()->socketbuf::close(); }
       }
       delete input_streams[i];
    }
    input_streams.DeleteAll();
+   for (int i = input_mesh_pieces.Size()-1; i >= 0; i--)
+   {
+      delete input_gf_pieces[i];
+      delete input_mesh_pieces[i];
+   }
+   input_gf_pieces.DeleteAll();
+   input_mesh_pieces.DeleteAll();
 }
 
-// Replace a given VectorFiniteElement-based grid function (e.g. from a Nedelec
-// or Raviart-Thomas space) with a discontinuous piece-wise polynomial Cartesian
-// product vector grid function of the same order.
-GridFunction *ProjectVectorFEGridFunction(GridFunction *gf)
-{
-   if ((gf->VectorDim() == 3) && (gf->FESpace()->GetVDim() == 1))
-   {
-      int p = gf->FESpace()->GetOrder(0);
-      cout << "Switching to order " << p
-           << " discontinuous vector grid function..." << endl;
-      int dim = gf->FESpace()->GetMesh()->Dimension();
-      FiniteElementCollection *d_fec = new L2_FECollection(p, dim, 1);
-      FiniteElementSpace *d_fespace =
-         new FiniteElementSpace(gf->FESpace()->GetMesh(), d_fec, 3);
-      GridFunction *d_gf = new GridFunction(d_fespace);
-      d_gf->MakeOwner(d_fec);
-      gf->ProjectVectorFieldOn(*d_gf);
-      delete gf;
-      return d_gf;
-   }
-   return gf;
-}
-
-void Extrude1DMeshAndSolution(Mesh **mesh_p, GridFunction **grid_f_p,
+bool Extrude1DMeshAndSolution(Mesh **mesh_p, GridFunction **grid_f_p,
                               Vector *sol)
 {
    Mesh *mesh = *mesh_p;
 
    if (mesh->Dimension() != 1 || mesh->SpaceDimension() != 1)
    {
-      return;
+      return false;
+   }
+
+   // scalar solutions are drawn by VisualizationSceneSolution1d
+   const bool scalar = (grid_f_p && *grid_f_p) ?
+                       ((*grid_f_p)->VectorDim() == 1) : (sol != NULL);
+   if (scalar)
+   {
+      return false;
    }
 
    // find xmin and xmax over the vertices of the 1D mesh
@@ -2179,4 +3249,6 @@ void Extrude1DMeshAndSolution(Mesh **mesh_p, GridFunction **grid_f_p,
 
    delete mesh;
    *mesh_p = mesh2d;
+
+   return true;
 }
@@ -0,0 +1,195 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#include <string>
+#include "visual.hpp"
+
+using namespace std;
+
+void GetAggregatorRanks(int nproc, int num_groups, int group,
+                        int &first, int &end)
+{
+   // the smallest p with p*num_groups >= group*nproc
+   first = int((long(group)*nproc + num_groups - 1)/num_groups);
+   end = int((long(group + 1)*nproc + num_groups - 1)/num_groups);
+}
+
+// The arguments of the stream commands: 'w' is a word or a number and 'q' is a
+// string delimited by its first character.
+struct StreamCommand
+{
+   const char *name, *args;
+};
+
+static const StreamCommand stream_commands[] =
+{
+   { "control", "w" },
+   { "screenshot", "w" },
+   { "keys", "w" },
+   { "window_size", "ww" },
+   { "window_geometry", "wwww" },
+   { "window_title", "q" },
+   { "plot_caption", "q" },
+   { "axis_labels", "qqq" },
+   { "pause", "" },
+   { "view", "ww" },
+   { "zoom", "w" },
+   { "subdivisions", "ww" },
+   { "valuerange", "ww" },
+   { "shading", "w" },
+   { "viewcenter", "ww" },
+   { "autoscale", "w" },
+   { "palette", "w" },
+   { "camera", "wwwwwwwww" },
+   { "autopause", "w" },
+   { NULL, NULL }
+};
+
+// Read the arguments of a command from 'is' and return them as they should be
+// sent, each one preceded by a space.
+static string ReadCommandArgs(istream &is, const char *args)
+{
+   string text, arg;
+   for ( ; *args; args++)
+   {
+      if (*args == 'w')
+      {
+         is >> ws >> arg;
+         text += ' ' + arg;
+      }
+      else
+      {
+         char c;
+         is >> ws >> c;
+         getline(is, arg, c);
+         text += ' ' + (c + arg) + c;
+      }
+   }
+   return text;
+}
+
+int AggregateParallelSession(Array<istream *> &is, int nproc, int first_rank,
+                             const char *host, int port, int num_groups,
+                             int group, bool fix_elem_orient, bool keep_attr)
+{
+   socketstream up(host, port);
+   if (!up.is_open())
+   {
+      cout << "Aggregator: cannot connect to " << host << ':' << port << endl;
+      return 1;
+   }
+   up.precision(16);
+
+   const int n = is.Size();
+   Array<Mesh *> mesh_pieces;
+   Array<GridFunction *> gf_pieces;
+   Mesh *mesh = NULL; // the merged mesh last sent
+   string ident = "parallel";
+   bool header_read = true;
+
+   while (1)
+   {
+      if (!header_read)
+      {
+         *is[0] >> ws >> ident;
+         if (!*is[0])
+         {
+            cout << "Aggregator: end of input." << endl;
+            break;
+         }
+      }
+
+      if (ident == "parallel")
+      {
+         ParStreamData psd(is, mesh_pieces, fix_elem_orient, keep_attr, true);
+         psd.nproc = nproc;
+         psd.first_rank = first_rank;
+         psd.header_read = header_read;
+         header_read = false;
+
+         // read the pieces from all ranks concurrently
+         ParallelFor(n, ReadParStream, &psd);
+         if (!psd.CheckSolutions(gf_pieces))
+         {
+            psd.DeleteNewData();
+            break;
+         }
+         const bool new_mesh = (psd.num_updates + psd.num_unchanged < n);
+         const int num_updates = psd.num_updates;
+         psd.ReplacePieces(gf_pieces);
+
+         up << "parallel " << num_groups << ' ' << group << '\n';
+         if (new_mesh)
+         {
+            delete mesh;
+            mesh = new Mesh(mesh_pieces, n);
+            GridFunction *gf = NULL;
+            if (gf_pieces[0])
+            {
+               gf = MergeGridFunctionPieces(mesh, gf_pieces, false);
+            }
+            up << "binary\n";
+            WriteBinaryMeshAndSolution(up, *mesh, gf);
+            delete gf;
+         }
+         else if (num_updates > 0)
+         {
+            GridFunction *gf = MergeGridFunctionPieces(mesh, gf_pieces, false);
+            up << "update\n";
+            gf->Save(up);
+            delete gf;
+         }
+         else
+         {
+            up << "unchanged\n";
+         }
+      }
+      else
+      {
+         const StreamCommand *cmd = stream_commands;
+         while (cmd->name && ident != cmd->name)
+         {
+            cmd++;
+         }
+         if (!cmd->name)
+         {
+            cout << "Aggregator: unknown command: " << ident << endl;
+            break;
+         }
+         const string args = ReadCommandArgs(*is[0], cmd->args);
+
+         // all processors sent the command
+         for (int i = 1; i < n; i++)
+         {
+            *is[i] >> ws >> ident;
+            ReadCommandArgs(*is[i], cmd->args);
+         }
+         up << cmd->name << args << '\n';
+      }
+
+      up << flush;
+      if (!up)
+      {
+         cout << "Aggregator: connection to " << host << ':' << port
+              << " closed." << endl;
+         break;
+      }
+   }
+
+   delete mesh;
+   for (int p = mesh_pieces.Size()-1; p >= 0; p--)
+   {
+      delete gf_pieces[p];
+      delete mesh_pieces[p];
+   }
+   return 0;
+}
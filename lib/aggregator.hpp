@@ -0,0 +1,46 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#ifndef GLVIS_AGGREGATOR
+#define GLVIS_AGGREGATOR
+
+#include <iostream>
+#include "mfem.hpp"
+using namespace mfem;
+
+// Aggregator mode: instead of opening a window, GLVis accepts the connections
+// of a block of the ranks of a parallel session, merges their pieces and sends
+// them, as a single rank, to another GLVis server or aggregator. With
+// 'num_groups' aggregators, aggregator 'group' accepts the ranks p with
+// p*num_groups/nproc == group, and sends its data with the header
+// "parallel num_groups group". Aggregators can be chained in a tree, so the
+// final GLVis server receives a fixed number of connections.
+//
+// Updates are forwarded as "binary" data when a rank sent a new mesh, as
+// "update" when only solutions changed and as "unchanged" otherwise. The other
+// stream commands, which all ranks send, are forwarded once.
+
+/// Return the block of ranks [first, end) handled by aggregator 'group' of
+/// 'num_groups' in a session with 'nproc' ranks.
+void GetAggregatorRanks(int nproc, int num_groups, int group,
+                        int &first, int &end);
+
+/// Forward the parallel session read from the streams 'is' of the ranks
+/// [first_rank, first_rank + is.Size()) of 'nproc', whose headers have been
+/// read, to the server at host:port. Returns when the session ends; returns
+/// non-zero if the server could not be reached.
+int AggregateParallelSession(Array<std::istream *> &is, int nproc,
+                             int first_rank, const char *host, int port,
+                             int num_groups, int group, bool fix_elem_orient,
+                             bool keep_attr);
+
+#endif
@@ -310,6 +310,11 @@ void auxInitDisplayMode(GLenum type)
     tkInitDisplayMode(type);
 }
 
+GLenum auxInitDisplay(void)
+{
+    return tkInitDisplay();
+}
+
 GLenum auxInitWindow(const char *title)
 {
     int useDoubleAsSingle = 0;
@@ -245,6 +245,7 @@ typedef struct _AUX_RGBImageRec {
 
 extern void auxInitDisplayMode(GLenum);
 extern void auxInitPosition(int, int, int, int);
+extern GLenum auxInitDisplay(void);
 extern GLenum auxInitWindow(const char *);
 extern void auxCloseWindow(void);
 extern void auxQuit(void);
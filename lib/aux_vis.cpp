@@ -52,7 +52,7 @@ static int glvis_multisample = -1;
 
 void MyExpose(GLsizei w, GLsizei h);
 
-int InitVisualization (const char name[], int x, int y, int w, int h)
+static void InitPalettesOnce()
 {
    static int init = 0;
 
@@ -61,14 +61,51 @@ int InitVisualization (const char name[], int x, int y, int w, int h)
       Init_Palettes();
       init = 1;
    }
+}
+
+static void InitDisplayMode()
+{
+   GLenum mode = AUX_DOUBLE | AUX_RGBA | AUX_DEPTH;
+   // mode |= (AUX_ALPHA | AUX_ACCUM);
+   auxInitDisplayMode(mode);
+}
+
+#ifdef GLVIS_USE_FREETYPE
+static void FindFontFileOnce();
+static void InitFont();
+#endif
+
+void PrepareSharedVisualizationData()
+{
+   InitPalettesOnce();
+#ifdef GLVIS_USE_FREETYPE
+   FindFontFileOnce();
+#endif
+}
+
+int PrepareVisualization()
+{
+   InitPalettesOnce();
+   InitDisplayMode();
+   if (auxInitDisplay() == GL_FALSE)
+   {
+      return 1;
+   }
+#ifdef GLVIS_USE_FREETYPE
+   InitFont();
+#endif
+   return 0;
+}
+
+int InitVisualization (const char name[], int x, int y, int w, int h)
+{
+   InitPalettesOnce();
 
 #ifdef GLVIS_DEBUG
    cout << "OpenGL Visualization" << endl;
 #endif
 
-   GLenum mode = AUX_DOUBLE | AUX_RGBA | AUX_DEPTH;
-   // mode |= (AUX_ALPHA | AUX_ACCUM);
-   auxInitDisplayMode(mode);
+   InitDisplayMode();
    auxInitPosition(x, y, w, h);
    if (auxInitWindow(name) == GL_FALSE)
    {
@@ -1766,6 +1803,7 @@ private:
       alloc_glyphs = num_glyphs = 0;
    }
 
+public:
    static int FindFontFile(const char *font_patterns[], int num_patterns,
                            string &font_file)
    {
@@ -1849,7 +1887,6 @@ private:
       return s ? 0 : -2;
    }
 
-public:
    GLVisFont() { init = 0; }
 
    int Initialized() const { return init; }
@@ -1859,6 +1896,21 @@ public:
       SetFont(font_patterns, num_patterns, height);
    }
 
+   // Initialize from a font file found with FindFontFile(); an empty name
+   // means that no font was found.
+   void InitFile(const string &font_file, int height)
+   {
+      if (font_file.empty())
+      {
+         if (!init)
+         {
+            init = -4;
+         }
+         return;
+      }
+      SetFontFile(font_file.c_str(), height);
+   }
+
    int SetFont(const char *font_patterns[], int num_patterns, int height)
    {
       string font_file;
@@ -2108,31 +2160,57 @@ int font_size = 12;
 
 GLVisFont glvis_font;
 
-int RenderBitmapText(const char *text, int &width, int &height)
+// The font file found by FindFontFileOnce() and the 'fontname' it was found
+// for; an empty file name means that no font was found.
+static string found_font_file, found_font_name;
+static bool font_file_found = false;
+
+// Find the font file with fontconfig, if not done already for 'fontname'
+static void FindFontFileOnce()
 {
-   if (!glvis_font.Initialized())
+   if (font_file_found && found_font_name == fontname)
    {
-      if (fontname.empty())
-      {
-         glvis_font.Init(fc_font_patterns, num_font_patterns, font_size);
-      }
-      else
+      return;
+   }
+   found_font_file.clear();
+   if (!fontname.empty())
+   {
+      const char *fc_pat[1];
+      fc_pat[0] = fontname.c_str();
+      if (GLVisFont::FindFontFile(fc_pat, 1, found_font_file))
       {
-         const char *fc_pat[1];
-         fc_pat[0] = fontname.c_str();
-         glvis_font.Init(fc_pat, 1, font_size);
-         if (glvis_font.Initialized() == -4)
-         {
-            cout << "Font not found: " << fontname << endl;
-            glvis_font.Init(fc_font_patterns, num_font_patterns, font_size);
-         }
+         cout << "Font not found: " << fontname << endl;
+         found_font_file.clear();
       }
+   }
+   if (found_font_file.empty() &&
+       GLVisFont::FindFontFile(fc_font_patterns, num_font_patterns,
+                               found_font_file))
+   {
+      found_font_file.clear();
+   }
+   found_font_name = fontname;
+   font_file_found = true;
+}
+
+// Find and load the font, if not done already
+static void InitFont()
+{
+   if (!glvis_font.Initialized())
+   {
+      FindFontFileOnce();
+      glvis_font.InitFile(found_font_file, font_size);
 
       if (glvis_font.Initialized() == -4)
          cout <<
               "GLVis: No fonts found! Use the -fn option or"
               " edit 'fc_font_patterns' in lib/aux_vis.cpp" << endl;
    }
+}
+
+int RenderBitmapText(const char *text, int &width, int &height)
+{
+   InitFont();
 
    int fail = glvis_font.Render(text);
 
@@ -25,6 +25,18 @@ extern GLuint fontbase;
 extern float MatAlpha;
 extern float MatAlphaCenter;
 
+/// Initializes the data of the visualization that does not depend on the
+/// display: the palettes and the location of the font file. The server calls
+/// this before it starts any session, so that the session processes share the
+/// data (copy-on-write) instead of each computing it again.
+void PrepareSharedVisualizationData();
+
+/// Initializes the parts of the visualization that do not need a window: the
+/// palettes, the connection to the display, the visual, the OpenGL context and
+/// the font, so that InitVisualization() only has to create the window.
+/// Returns 0 on success.
+int PrepareVisualization();
+
 /// Initializes the visualization and some keys.
 int InitVisualization(const char name[], int x, int y, int w, int h);
 
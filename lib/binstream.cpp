@@ -0,0 +1,553 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+#include <stdint.h>
+#include <climits>     // INT_MAX
+#include <cstdio>      // perror
+#include <cstring>     // memcmp
+#include <iostream>
+#include <string>
+#include <sys/mman.h>  // shm_open, shm_unlink, mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <fcntl.h>     // O_RDONLY
+#include <unistd.h>    // close
+#include <sys/socket.h> // getpeername, getsockname
+#include <netinet/in.h> // sockaddr_in, sockaddr_in6
+#include <arpa/inet.h>  // ntohl
+#include "binstream.hpp"
+#include "meshcache.hpp"
+#include "zstream.hpp"
+
+using namespace std;
+
+static bool HostIsLittleEndian()
+{
+   const int one = 1;
+   return (*(const char *)&one == 1);
+}
+
+// Convert 'n' items of 'size' bytes between little-endian and host order
+static void SwapBytes(void *data, int size, size_t n)
+{
+   if (HostIsLittleEndian()) { return; }
+   char *p = (char *)data;
+   for (size_t i = 0; i < n; i++, p += size)
+   {
+      for (int j = 0; j < size/2; j++)
+      {
+         char c = p[j]; p[j] = p[size-1-j]; p[size-1-j] = c;
+      }
+   }
+}
+
+static bool ReadInts(istream &is, int *data, size_t n)
+{
+   if (sizeof(int) != 4) { return false; }
+   is.read((char *)data, 4*n);
+   SwapBytes(data, 4, n);
+   return bool(is);
+}
+
+static bool ReadDoubles(istream &is, double *data, size_t n)
+{
+   is.read((char *)data, 8*n);
+   SwapBytes(data, 8, n);
+   return bool(is);
+}
+
+static bool ReadBlockHeader(istream &is, string &tag, uint64_t &size)
+{
+   char t[4];
+   unsigned char s[8];
+   is.read(t, 4);
+   is.read((char *)s, 8);
+   if (!is) { return false; }
+   tag.assign(t, 4);
+   size = 0;
+   for (int i = 7; i >= 0; i--)
+   {
+      size = (size << 8) | s[i];
+   }
+   return true;
+}
+
+static void WriteBlockHeader(ostream &os, const char *tag, uint64_t size)
+{
+   unsigned char s[8];
+   for (int i = 0; i < 8; i++)
+   {
+      s[i] = (unsigned char)(size >> (8*i));
+   }
+   os.write(tag, 4);
+   os.write((const char *)s, 8);
+}
+
+static void WriteInts(ostream &os, const int *data, size_t n)
+{
+   if (HostIsLittleEndian())
+   {
+      os.write((const char *)data, 4*n);
+      return;
+   }
+   for (size_t i = 0; i < n; i++)
+   {
+      int v = data[i];
+      SwapBytes(&v, 4, 1);
+      os.write((const char *)&v, 4);
+   }
+}
+
+static void WriteDoubles(ostream &os, const double *data, size_t n)
+{
+   if (HostIsLittleEndian())
+   {
+      os.write((const char *)data, 8*n);
+      return;
+   }
+   for (size_t i = 0; i < n; i++)
+   {
+      double v = data[i];
+      SwapBytes(&v, 8, 1);
+      os.write((const char *)&v, 8);
+   }
+}
+
+// Read the payload of a NODE or SOLN block and construct a GridFunction
+static GridFunction *ReadField(istream &is, uint64_t size, Mesh *mesh)
+{
+   int name_len, vdim_ord[2];
+   if (size < 12 || !ReadInts(is, &name_len, 1) || name_len < 0 ||
+       uint64_t(name_len) > size - 12)
+   {
+      return NULL;
+   }
+   string fec_name(name_len, ' ');
+   is.read(&fec_name[0], name_len);
+   if (!ReadInts(is, vdim_ord, 2))
+   {
+      return NULL;
+   }
+   // the values are checked against the space before they are allocated
+   const int vdim = vdim_ord[0], ordering = vdim_ord[1];
+   const uint64_t data_size = size - 12 - name_len;
+   if (data_size % 8 != 0 || data_size/8 > uint64_t(INT_MAX) ||
+       vdim < 1 || uint64_t(vdim) > data_size/8 ||
+       (ordering != 0 && ordering != 1))
+   {
+      cerr << "Binary stream: invalid field block for " << fec_name << endl;
+      return NULL;
+   }
+   // like the text format, an unknown collection name is a fatal error
+   FiniteElementCollection *fec = NewFECollection(fec_name.c_str());
+   FiniteElementSpace *fes = new FiniteElementSpace(mesh, fec, vdim, ordering);
+   if (uint64_t(fes->GetNDofs())*vdim != data_size/8)
+   {
+      cerr << "Binary stream: invalid number of DOFs for "
+           << fec_name << endl;
+      delete fes;
+      delete fec;
+      return NULL;
+   }
+   GridFunction *gf = new GridFunction(fes);
+   gf->MakeOwner(fec);
+   if (!ReadDoubles(is, gf->GetData(), gf->Size()))
+   {
+      delete gf;
+      return NULL;
+   }
+   return gf;
+}
+
+// Read the payload of an ELEM or BDRE block and add the elements to 'mesh'
+static bool ReadElements(istream &is, uint64_t size, int num_elem,
+                         Mesh *mesh, bool bdr)
+{
+   // at most 2 + 8 integers per element (a cube)
+   if (size % 4 != 0 || size > 4*uint64_t(num_elem)*(2 + 8) ||
+       size/4 > uint64_t(INT_MAX))
+   {
+      return false;
+   }
+   const int nv = mesh->GetNV();
+   const int dim = mesh->Dimension() - (bdr ? 1 : 0);
+   Array<int> elems(int(size/4));
+   if (!ReadInts(is, elems.GetData(), elems.Size()))
+   {
+      return false;
+   }
+   int pos = 0;
+   for (int i = 0; i < num_elem; i++)
+   {
+      if (pos + 2 > elems.Size()) { return false; }
+      const int attr = elems[pos++];
+      const int geom = elems[pos++];
+      if (attr < 1 || geom < Geometry::POINT || geom > Geometry::CUBE ||
+          Geometry::Dimension[geom] != dim) { return false; }
+      const int nev = Geometry::NumVerts[geom];
+      if (pos + nev > elems.Size()) { return false; }
+      for (int j = 0; j < nev; j++)
+      {
+         if (elems[pos+j] < 0 || elems[pos+j] >= nv) { return false; }
+      }
+      Element *el = mesh->NewElement(geom);
+      el->SetVertices(&elems[pos]);
+      el->SetAttribute(attr);
+      pos += nev;
+      if (bdr)
+      {
+         mesh->AddBdrElement(el);
+      }
+      else
+      {
+         mesh->AddElement(el);
+      }
+   }
+   return (pos == elems.Size());
+}
+
+// Generate the mesh topology once all vertices and elements have been added;
+// returns false if their numbers do not match the MESH block
+static bool FinalizeMesh(Mesh *mesh, const int header[5], bool fix_elem_orient,
+                         bool &finalized)
+{
+   if (!finalized)
+   {
+      if (mesh->GetNV() != header[2] || mesh->GetNE() != header[3] ||
+          mesh->GetNBE() != header[4])
+      {
+         return false;
+      }
+      mesh->FinalizeTopology();
+      mesh->Finalize(false, fix_elem_orient);
+      finalized = true;
+   }
+   return true;
+}
+
+int ReadBinaryMeshAndSolution(istream &is, Mesh **mesh_p,
+                              GridFunction **gf_p, bool fix_elem_orient)
+{
+   Mesh *mesh = NULL;
+   GridFunction *nodes = NULL, *gf = NULL; // 'nodes' is owned by 'mesh'
+   int header[5] = { 0, 0, 0, 0, 0 };
+   string tag;
+   uint64_t size;
+   int err = 0;
+   bool finalized = false;
+   bool have_vert = false, have_elem = false, have_bdre = false;
+
+   *mesh_p = NULL;
+   *gf_p = NULL;
+   while (!err)
+   {
+      if (!ReadBlockHeader(is, tag, size))
+      {
+         err = 1;
+         break;
+      }
+      if (tag == "END_")
+      {
+         break;
+      }
+      if (mesh == NULL && tag != "MESH")
+      {
+         err = 2;
+         break;
+      }
+      // the vertices and the elements are given once, before the fields
+      if ((tag == "VERT" && (finalized || have_vert)) ||
+          (tag == "ELEM" && (finalized || have_elem)) ||
+          (tag == "BDRE" && (finalized || have_bdre)))
+      {
+         err = 2;
+         break;
+      }
+      if (tag == "MESH")
+      {
+         if (mesh || size != sizeof(header) || !ReadInts(is, header, 5) ||
+             header[0] < 1 || header[0] > 3 || header[1] < header[0] ||
+             header[1] > 3 || header[2] < 0 || header[3] < 0 || header[4] < 0)
+         {
+            err = 3;
+            break;
+         }
+         mesh = new Mesh(header[0], header[2], header[3], header[4],
+                         header[1]);
+      }
+      else if (tag == "VERT")
+      {
+         const int nv = header[2], sdim = header[1];
+         if (size != 8*uint64_t(nv)*sdim || size/8 > uint64_t(INT_MAX))
+         {
+            err = 4;
+            break;
+         }
+         Vector verts(nv*sdim);
+         if (!ReadDoubles(is, verts.GetData(), verts.Size()))
+         {
+            err = 4;
+            break;
+         }
+         have_vert = true;
+         for (int i = 0; i < nv; i++)
+         {
+            mesh->AddVertex(&verts(i*sdim));
+         }
+      }
+      else if (tag == "ELEM" || tag == "BDRE")
+      {
+         const bool bdr = (tag == "BDRE");
+         if (!ReadElements(is, size, header[bdr ? 4 : 3], mesh, bdr))
+         {
+            err = 5;
+            break;
+         }
+         (bdr ? have_bdre : have_elem) = true;
+      }
+      else if (tag == "NODE" || tag == "SOLN")
+      {
+         // the topology must be complete before building the FE space
+         if (!FinalizeMesh(mesh, header, fix_elem_orient, finalized))
+         {
+            err = 5;
+            break;
+         }
+         GridFunction *f = ReadField(is, size, mesh);
+         if (f == NULL)
+         {
+            err = 6;
+            break;
+         }
+         if (tag == "SOLN")
+         {
+            delete gf;
+            gf = f;
+         }
+         else if (nodes == NULL)
+         {
+            nodes = f;
+            mesh->NewNodes(*nodes, true);
+         }
+         else
+         {
+            delete f;
+            err = 6;
+            break;
+         }
+      }
+      else
+      {
+         // skip unknown blocks
+         is.ignore(size);
+      }
+   }
+
+   if (!err && mesh == NULL)
+   {
+      err = 2;
+   }
+   if (!err && !FinalizeMesh(mesh, header, fix_elem_orient, finalized))
+   {
+      err = 5;
+   }
+   if (err)
+   {
+      cerr << "Binary stream: invalid data (error " << err << ")" << endl;
+      delete gf;
+      delete mesh; // owns 'nodes'
+      return err;
+   }
+
+   *mesh_p = mesh;
+   *gf_p = gf;
+   return 0;
+}
+
+// Return true if the peer of the socket 'sd' is on the same host: a Unix
+// domain socket, a loopback address or the local address of the socket
+static bool IsLocalPeer(int sd)
+{
+   struct sockaddr_storage peer, local;
+   socklen_t peer_len = sizeof(peer), local_len = sizeof(local);
+   if (getpeername(sd, (struct sockaddr *)&peer, &peer_len) == -1)
+   {
+      return false;
+   }
+   if (peer.ss_family == AF_UNIX)
+   {
+      return true;
+   }
+   if (peer.ss_family == AF_INET)
+   {
+      const struct sockaddr_in *p = (const struct sockaddr_in *)&peer;
+      if ((ntohl(p->sin_addr.s_addr) >> 24) == 127)
+      {
+         return true;
+      }
+   }
+   else if (peer.ss_family == AF_INET6)
+   {
+      const struct sockaddr_in6 *p = (const struct sockaddr_in6 *)&peer;
+      const uint8_t *a = p->sin6_addr.s6_addr;
+      if (IN6_IS_ADDR_LOOPBACK(&p->sin6_addr) ||
+          (IN6_IS_ADDR_V4MAPPED(&p->sin6_addr) && a[12] == 127))
+      {
+         return true;
+      }
+   }
+   else
+   {
+      return false;
+   }
+   if (getsockname(sd, (struct sockaddr *)&local, &local_len) == -1 ||
+       local.ss_family != peer.ss_family)
+   {
+      return false;
+   }
+   if (peer.ss_family == AF_INET)
+   {
+      return (((const struct sockaddr_in *)&peer)->sin_addr.s_addr ==
+              ((const struct sockaddr_in *)&local)->sin_addr.s_addr);
+   }
+   return (memcmp(&((const struct sockaddr_in6 *)&peer)->sin6_addr,
+                  &((const struct sockaddr_in6 *)&local)->sin6_addr,
+                  sizeof(struct in6_addr)) == 0);
+}
+
+int ReadBinaryData(const string &data_type, istream &is, Mesh **mesh_p,
+                   GridFunction **gf_p, bool fix_elem_orient)
+{
+   if (data_type != "shm")
+   {
+      return ReadBinaryMeshAndSolution(is, mesh_p, gf_p, fix_elem_orient);
+   }
+
+   string name;
+   size_t size;
+   is >> ws >> name >> size >> ws;
+   *mesh_p = NULL;
+   *gf_p = NULL;
+   if (!is)
+   {
+      cerr << "Shared memory: invalid header" << endl;
+      return 7;
+   }
+   // only clients on the same host may name objects, and only GLVis objects
+   socketstream *sock = GetSocketStream(&is);
+   if (sock && !IsLocalPeer(sock->rdbuf()->getsocketdescriptor()))
+   {
+      cerr << "Shared memory: not accepted from a remote host" << endl;
+      return 7;
+   }
+   if (name.compare(0, 7, "/glvis_") != 0 || name.size() == 7 ||
+       name.find('/', 1) != string::npos)
+   {
+      cerr << "Shared memory: invalid object name " << name << endl;
+      return 7;
+   }
+   int fd = shm_open(name.c_str(), O_RDONLY, 0);
+   if (fd == -1)
+   {
+      perror("shm_open()");
+      return 7;
+   }
+   struct stat st;
+   if (fstat(fd, &st) == -1 || size_t(st.st_size) < size)
+   {
+      cerr << "Shared memory: object " << name << " is too small" << endl;
+      close(fd);
+      shm_unlink(name.c_str());
+      return 7;
+   }
+   if (size == 0)
+   {
+      cerr << "Shared memory: object " << name << " has no data" << endl;
+      close(fd);
+      shm_unlink(name.c_str());
+      return 7;
+   }
+   void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   // the object is not needed after it is mapped
+   shm_unlink(name.c_str());
+   if (data == MAP_FAILED)
+   {
+      perror("mmap()");
+      return 7;
+   }
+
+   membuf buf((char *)data, size);
+   istream mis(&buf);
+   int err = ReadBinaryMeshAndSolution(mis, mesh_p, gf_p, fix_elem_orient);
+   munmap(data, size);
+   return err;
+}
+
+static void WriteField(ostream &os, const char *tag, GridFunction &gf)
+{
+   const FiniteElementSpace *fes = gf.FESpace();
+   const string fec_name = fes->FEColl()->Name();
+   const int name_len = fec_name.size();
+   const int vdim_ord[2] = { fes->GetVDim(), fes->GetOrdering() };
+
+   WriteBlockHeader(os, tag, 12 + name_len + 8*uint64_t(gf.Size()));
+   WriteInts(os, &name_len, 1);
+   os.write(fec_name.data(), name_len);
+   WriteInts(os, vdim_ord, 2);
+   WriteDoubles(os, gf.GetData(), gf.Size());
+}
+
+static void WriteElements(ostream &os, const char *tag, Mesh &mesh,
+                          bool bdr)
+{
+   const int ne = bdr ? mesh.GetNBE() : mesh.GetNE();
+   Array<int> elems;
+   for (int i = 0; i < ne; i++)
+   {
+      const Element *el = bdr ? mesh.GetBdrElement(i) : mesh.GetElement(i);
+      const int *v = el->GetVertices();
+      elems.Append(el->GetAttribute());
+      elems.Append(el->GetGeometryType());
+      for (int j = 0; j < el->GetNVertices(); j++)
+      {
+         elems.Append(v[j]);
+      }
+   }
+   WriteBlockHeader(os, tag, 4*uint64_t(elems.Size()));
+   WriteInts(os, elems.GetData(), elems.Size());
+}
+
+void WriteBinaryMeshAndSolution(ostream &os, Mesh &mesh, GridFunction *gf)
+{
+   const int sdim = mesh.SpaceDimension();
+   const int header[5] = { mesh.Dimension(), sdim, mesh.GetNV(),
+                           mesh.GetNE(), mesh.GetNBE()
+                         };
+   WriteBlockHeader(os, "MESH", sizeof(header));
+   WriteInts(os, header, 5);
+
+   WriteBlockHeader(os, "VERT", 8*uint64_t(mesh.GetNV())*sdim);
+   for (int i = 0; i < mesh.GetNV(); i++)
+   {
+      WriteDoubles(os, mesh.GetVertex(i), sdim);
+   }
+   WriteElements(os, "ELEM", mesh, false);
+   WriteElements(os, "BDRE", mesh, true);
+   if (mesh.GetNodes())
+   {
+      WriteField(os, "NODE", *mesh.GetNodes());
+   }
+   if (gf)
+   {
+      WriteField(os, "SOLN", *gf);
+   }
+   WriteBlockHeader(os, "END_", 0);
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+#ifndef GLVIS_BINSTREAM
+#define GLVIS_BINSTREAM
+
+#include "mfem.hpp"
+using namespace mfem;
+
+// Binary mesh and solution data, sent after the data type keyword "binary".
+//
+// The data is a sequence of blocks, each one consisting of a 4-character tag,
+// the size of the payload in bytes as a 64-bit little-endian integer, and the
+// payload. All integers are 32-bit and all reals are 64-bit IEEE doubles, both
+// little-endian. The blocks are:
+//
+//   MESH - dim, space_dim, num_vertices, num_elements, num_bdr_elements
+//   VERT - num_vertices x space_dim vertex coordinates (vertex by vertex)
+//   ELEM - for every element: attribute, geometry type (mfem::Geometry::Type)
+//          and the vertex indices of the element
+//   BDRE - same as ELEM, for the boundary elements
+//   NODE - (optional) curved mesh nodes, in the same format as SOLN
+//   SOLN - (optional) solution: length of the FE collection name, the name,
+//          vdim, ordering and the DOF values (until the end of the block)
+//   END_ - empty block, marks the end of the data
+//
+// MESH must come first and the blocks with unknown tags are skipped. VERT,
+// ELEM and BDRE may appear only once, before NODE and SOLN, and must give the
+// numbers of vertices and elements in MESH; the element attributes must be
+// positive and the element dimensions must match the mesh. Without a SOLN
+// block the data represents only a mesh.
+//
+// Same-host clients can avoid sending the data through the socket: with the
+// data type keyword "shm", the client writes the binary data into a POSIX
+// shared memory object and sends only "shm <name> <size>", where <name> is the
+// name of the object (as given to shm_open) and <size> is the size of the data
+// in bytes. GLVis maps the object, reads the data and then unlinks the object,
+// so the client should use a new object for every update. The name must start
+// with "/glvis_", and "shm" is accepted only from sockets whose peer is on the
+// same host (Unix domain sockets and loopback or local addresses).
+
+/// Return true if 'data_type' is one of the binary data types, "binary" or
+/// "shm".
+inline bool IsBinaryDataType(const std::string &data_type)
+{ return (data_type == "binary" || data_type == "shm"); }
+
+/// Read binary mesh and solution data from the stream 'is'. On success, sets
+/// *mesh_p and *gf_p (NULL, for mesh-only data) and returns 0.
+int ReadBinaryMeshAndSolution(std::istream &is, Mesh **mesh_p,
+                              GridFunction **gf_p, bool fix_elem_orient);
+
+/// Read binary mesh and solution data of type 'data_type' ("binary" or "shm")
+/// from the stream 'is', see ReadBinaryMeshAndSolution().
+int ReadBinaryData(const std::string &data_type, std::istream &is,
+                   Mesh **mesh_p, GridFunction **gf_p, bool fix_elem_orient);
+
+/// Write 'mesh' and (optionally) 'gf' to the stream 'os' in the binary format.
+void WriteBinaryMeshAndSolution(std::ostream &os, Mesh &mesh,
+                                GridFunction *gf);
+
+/// Read-only stream buffer over a block of memory, e.g. mapped binary data.
+class membuf : public std::streambuf
+{
+public:
+   membuf(char *data, size_t size) { setg(data, data, data + size); }
+};
+
+#endif
@@ -0,0 +1,186 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#include <stdint.h>
+#include <climits>
+#include <cstdio>      // rename, remove
+#include <cstdlib>     // realpath
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "visual.hpp"
+
+using namespace std;
+
+static string cache_dir;
+
+// Version of the header of the cache files
+static const char cache_magic[] = "GLVis file cache v1";
+
+void SetFileCacheDir(const char *dir)
+{
+   cache_dir = dir ? dir : "";
+   if (!cache_dir.empty())
+   {
+      mkdir(cache_dir.c_str(), 0755);
+   }
+}
+
+// Describe a file by its absolute path, size, inode and modification and
+// status change times, with nanoseconds, so that a file rewritten in place
+// within the same second is not mistaken for the cached one; the description
+// is a line of the header of the cache file. Returns false if the file does
+// not exist.
+static bool DescribeFile(const char *file, string &path, string &desc)
+{
+   char buf[PATH_MAX];
+   struct stat st;
+   if (!realpath(file, buf) || stat(buf, &st) != 0)
+   {
+      return false;
+   }
+#ifdef __APPLE__
+   const long mtime_ns = st.st_mtimespec.tv_nsec;
+   const long ctime_ns = st.st_ctimespec.tv_nsec;
+#else
+   const long mtime_ns = st.st_mtim.tv_nsec;
+   const long ctime_ns = st.st_ctim.tv_nsec;
+#endif
+   path = buf;
+   ostringstream os;
+   os << path << ' ' << st.st_size << ' ' << st.st_mtime << '.' << mtime_ns
+      << ' ' << st.st_ctime << '.' << ctime_ns << ' ' << st.st_ino;
+   desc = os.str();
+   return true;
+}
+
+// Build the header of the cache file of the given files and its name, which
+// is derived from the paths of the files. Returns false if a file is missing.
+static bool MakeCacheHeader(const char *mesh_file, const char *sol_file,
+                            bool fix_elem_orient, string &header,
+                            string &cache_file)
+{
+   string mesh_path, mesh_desc, sol_path, sol_desc = "-";
+   if (cache_dir.empty() || !DescribeFile(mesh_file, mesh_path, mesh_desc))
+   {
+      return false;
+   }
+   if (sol_file && !DescribeFile(sol_file, sol_path, sol_desc))
+   {
+      return false;
+   }
+   header = string(cache_magic) + '\n' + mesh_desc + '\n' + sol_desc + '\n' +
+            (fix_elem_orient ? "1\n" : "0\n");
+
+   // 64-bit FNV-1a hash of the paths and options
+   const string key = mesh_path + '\n' + sol_path +
+                      (fix_elem_orient ? "\n1" : "\n0");
+   uint64_t h = 14695981039346656037ULL;
+   for (size_t i = 0; i < key.size(); i++)
+   {
+      h = (h ^ (unsigned char)key[i]) * 1099511628211ULL;
+   }
+   char name[32];
+   snprintf(name, sizeof(name), "%016llx.glvis", (unsigned long long)h);
+   cache_file = cache_dir + '/' + name;
+   return true;
+}
+
+bool LoadFromFileCache(const char *mesh_file, const char *sol_file,
+                       bool fix_elem_orient, Mesh **mesh_p,
+                       GridFunction **gf_p)
+{
+   string header, cache_file;
+   if (!MakeCacheHeader(mesh_file, sol_file, fix_elem_orient, header,
+                        cache_file))
+   {
+      return false;
+   }
+   int fd = open(cache_file.c_str(), O_RDONLY);
+   if (fd < 0)
+   {
+      return false;
+   }
+   struct stat st;
+   void *data = MAP_FAILED;
+   if (fstat(fd, &st) == 0 && size_t(st.st_size) > header.size())
+   {
+      data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   }
+   close(fd);
+   if (data == MAP_FAILED)
+   {
+      return false;
+   }
+
+   bool loaded = false;
+   if (header.compare(0, string::npos, (const char *)data,
+                      header.size()) == 0)
+   {
+      const size_t size = st.st_size - header.size();
+      membuf buf((char *)data + header.size(), size);
+      istream is(&buf);
+      Mesh *mesh;
+      GridFunction *gf;
+      if (ReadBinaryMeshAndSolution(is, &mesh, &gf, fix_elem_orient) == 0)
+      {
+         if ((gf != NULL) == (sol_file != NULL))
+         {
+            *mesh_p = mesh;
+            *gf_p = gf;
+            loaded = true;
+         }
+         else
+         {
+            delete gf;
+            delete mesh;
+         }
+      }
+   }
+   munmap(data, st.st_size);
+   return loaded;
+}
+
+void SaveToFileCache(const char *mesh_file, const char *sol_file,
+                     bool fix_elem_orient, Mesh &mesh, GridFunction *gf)
+{
+   string header, cache_file;
+   if (mesh.Nonconforming() || mesh.NURBSext ||
+       !MakeCacheHeader(mesh_file, sol_file, fix_elem_orient, header,
+                        cache_file))
+   {
+      return;
+   }
+
+   // write to a temporary file and rename it, so that a concurrent GLVis
+   // never reads a partially written cache file
+   ostringstream tmp_name;
+   tmp_name << cache_file << ".tmp" << getpid();
+   const string tmp_file = tmp_name.str();
+   ofstream os(tmp_file.c_str(), ios::binary);
+   if (!os)
+   {
+      return;
+   }
+   os.write(header.data(), header.size());
+   WriteBinaryMeshAndSolution(os, mesh, gf);
+   os.close();
+   if (!os || rename(tmp_file.c_str(), cache_file.c_str()) != 0)
+   {
+      cerr << "Can not write the file cache " << cache_file << endl;
+      remove(tmp_file.c_str());
+   }
+}
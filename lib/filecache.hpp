@@ -0,0 +1,45 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#ifndef GLVIS_FILECACHE
+#define GLVIS_FILECACHE
+
+#include "mfem.hpp"
+using namespace mfem;
+
+// Disk cache of meshes and solutions read from files. When enabled with
+// SetFileCacheDir(), the mesh and the (optional) grid function read from a
+// pair of files are saved in the binary format of binstream.hpp in the cache
+// directory, together with the paths, sizes and modification times of the
+// files. When the same files are opened again unchanged, the binary data is
+// memory-mapped and read instead of parsing the text.
+//
+// Nonconforming and NURBS meshes, which the binary format does not represent,
+// are not cached.
+
+/// Set the cache directory; NULL or an empty name disables the cache (the
+/// default). The directory is created if it does not exist.
+void SetFileCacheDir(const char *dir);
+
+/// Read the mesh in 'mesh_file' and the grid function in 'sol_file' (NULL for
+/// a mesh only) from the cache. Returns true and sets *mesh_p and *gf_p if the
+/// cache has the data of the current versions of the files.
+bool LoadFromFileCache(const char *mesh_file, const char *sol_file,
+                       bool fix_elem_orient, Mesh **mesh_p,
+                       GridFunction **gf_p);
+
+/// Save the mesh and the grid function (NULL for none) read from 'mesh_file'
+/// and 'sol_file' (NULL for none) to the cache.
+void SaveToFileCache(const char *mesh_file, const char *sol_file,
+                     bool fix_elem_orient, Mesh &mesh, GridFunction *gf);
+
+#endif
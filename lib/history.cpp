@@ -0,0 +1,222 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#include <cstring>
+#include "visual.hpp"
+
+#ifdef GLVIS_USE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace std;
+
+static int history_length = 0;
+static string history_codec = "none";
+static double history_fps = 10.0;
+
+bool SetSolutionHistory(int length, const char *codec, double fps)
+{
+   if (!SolutionHistory::CodecIsValid(codec))
+   {
+      return false;
+   }
+   history_length = length;
+   history_codec = codec;
+   history_fps = (fps > 0.0) ? fps : 10.0;
+   return true;
+}
+
+SolutionHistory *NewSolutionHistory()
+{
+   if (history_length <= 0)
+   {
+      return NULL;
+   }
+   return new SolutionHistory(history_length, history_codec.c_str());
+}
+
+double GetSolutionHistoryFPS()
+{
+   return history_fps;
+}
+
+SolutionHistory::SolutionHistory(int capacity, const char *codec_name)
+   : ring(capacity), first(0), count(0), mesh_hash(0), vsize(-1)
+{
+   const string c = codec_name;
+   codec = (c == "float") ? FLOAT : (c == "zlib") ? ZLIB : RAW;
+}
+
+bool SolutionHistory::CodecIsValid(const char *codec_name)
+{
+   const string c = codec_name;
+#ifdef GLVIS_USE_ZLIB
+   if (c == "zlib")
+   {
+      return true;
+   }
+#endif
+   return (c == "none" || c == "float");
+}
+
+void SolutionHistory::Encode(const Vector &v, vector<char> &buf) const
+{
+   const int n = v.Size();
+   const double *d = v.GetData();
+   switch (codec)
+   {
+      case RAW:
+         buf.resize(n*sizeof(double));
+         if (n > 0)
+         {
+            memcpy(&buf[0], d, n*sizeof(double));
+         }
+         break;
+
+      case FLOAT:
+      {
+         buf.resize(n*sizeof(float));
+         float *f = (float *)(n > 0 ? &buf[0] : NULL);
+         for (int i = 0; i < n; i++)
+         {
+            f[i] = float(d[i]);
+         }
+         break;
+      }
+
+      case ZLIB:
+      {
+#ifdef GLVIS_USE_ZLIB
+         // byte k of all values first, for k = 0..7: the exponents and the
+         // leading bits of the mantissas of nearby values then compress well
+         const size_t size = n*sizeof(double);
+         vector<unsigned char> shuffled(size);
+         const unsigned char *b = (const unsigned char *)d;
+         for (size_t k = 0; k < sizeof(double); k++)
+         {
+            for (int i = 0; i < n; i++)
+            {
+               shuffled[k*n+i] = b[i*sizeof(double)+k];
+            }
+         }
+         uLongf zsize = compressBound(size);
+         buf.resize(zsize);
+         if (size == 0 ||
+             compress2((Bytef *)&buf[0], &zsize, &shuffled[0], size,
+                       Z_BEST_SPEED) != Z_OK)
+         {
+            zsize = 0;
+         }
+         buf.resize(zsize);
+#endif
+         break;
+      }
+   }
+}
+
+void SolutionHistory::Decode(const vector<char> &buf, Vector &v) const
+{
+   const int n = v.Size();
+   double *d = v.GetData();
+   switch (codec)
+   {
+      case RAW:
+         if (n > 0)
+         {
+            memcpy(d, &buf[0], n*sizeof(double));
+         }
+         break;
+
+      case FLOAT:
+      {
+         const float *f = (const float *)(n > 0 ? &buf[0] : NULL);
+         for (int i = 0; i < n; i++)
+         {
+            d[i] = f[i];
+         }
+         break;
+      }
+
+      case ZLIB:
+      {
+#ifdef GLVIS_USE_ZLIB
+         const size_t size = n*sizeof(double);
+         vector<unsigned char> shuffled(size);
+         uLongf usize = size;
+         if (size == 0 ||
+             uncompress(&shuffled[0], &usize, (const Bytef *)&buf[0],
+                        buf.size()) != Z_OK || usize != size)
+         {
+            v = 0.0;
+            break;
+         }
+         unsigned char *b = (unsigned char *)d;
+         for (size_t k = 0; k < sizeof(double); k++)
+         {
+            for (int i = 0; i < n; i++)
+            {
+               b[i*sizeof(double)+k] = shuffled[k*n+i];
+            }
+         }
+#endif
+         break;
+      }
+   }
+}
+
+void SolutionHistory::Add(Mesh *mesh, const GridFunction &gf, bool same_mesh)
+{
+   const string name = gf.FESpace()->FEColl()->Name();
+   const uint64_t hash = (same_mesh && count > 0) ? mesh_hash : HashMesh(mesh);
+   if (count > 0 &&
+       (hash != mesh_hash || name != fec_name || gf.Size() != vsize))
+   {
+      cout << "History: new mesh or space, clearing " << count
+           << " solutions" << endl;
+      Clear();
+   }
+   mesh_hash = hash;
+   fec_name = name;
+   vsize = gf.Size();
+
+   const int capacity = ring.size();
+   int i;
+   if (count < capacity)
+   {
+      i = (first + count++) % capacity;
+   }
+   else
+   {
+      i = first;
+      first = (first + 1) % capacity;
+   }
+   Encode(gf, ring[i]);
+}
+
+void SolutionHistory::Get(int i, Vector &v) const
+{
+   if (i < 0 || i >= count || v.Size() != vsize)
+   {
+      return;
+   }
+   Decode(ring[(first + i) % ring.size()], v);
+}
+
+size_t SolutionHistory::Bytes() const
+{
+   size_t bytes = 0;
+   for (int i = 0; i < count; i++)
+   {
+      bytes += ring[(first + i) % ring.size()].size();
+   }
+   return bytes;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#ifndef GLVIS_HISTORY
+#define GLVIS_HISTORY
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "mfem.hpp"
+using namespace mfem;
+
+/// Ring buffer with the DOF vectors of the last solutions received through a
+/// stream on the same mesh and finite element space, used to step through and
+/// play back the previous time steps (see the -hist option). The vectors are
+/// stored with one of the codecs:
+///   "none"  - the doubles, as they are;
+///   "float" - rounded to single precision (lossy, half the memory);
+///   "zlib"  - byte-shuffled and deflated (lossless, requires zlib).
+class SolutionHistory
+{
+private:
+   enum Codec { RAW, FLOAT, ZLIB };
+
+   Codec codec;
+   std::vector<std::vector<char> > ring;
+   int first, count;
+
+   // the mesh and space of the stored solutions
+   uint64_t mesh_hash;
+   std::string fec_name;
+   int vsize;
+
+   void Encode(const Vector &v, std::vector<char> &buf) const;
+   void Decode(const std::vector<char> &buf, Vector &v) const;
+
+public:
+   /// Keep up to 'capacity' solutions encoded with the codec named 'codec',
+   /// which should be valid, see CodecIsValid().
+   SolutionHistory(int capacity, const char *codec);
+
+   /// Return true if 'codec' names a codec available in this build.
+   static bool CodecIsValid(const char *codec);
+
+   /// Append the solution 'gf' on 'mesh', replacing the oldest one if the
+   /// buffer is full. If the mesh or the space are different from the ones of
+   /// the stored solutions, the buffer is cleared first. With 'same_mesh',
+   /// the mesh is known to be the one of the last call.
+   void Add(Mesh *mesh, const GridFunction &gf, bool same_mesh);
+
+   void Clear() { first = count = 0; }
+
+   /// Number of stored solutions; 0 is the oldest, Size()-1 the newest.
+   int Size() const { return count; }
+
+   /// Decode solution 'i' into 'v', which has the size of the stored vectors.
+   void Get(int i, Vector &v) const;
+
+   /// Total size of the encoded solutions, in bytes.
+   size_t Bytes() const;
+};
+
+/// Settings for the histories of the stream solutions: 'length' solutions
+/// (0 disables the history) stored with 'codec', played back at 'fps' frames
+/// per second. Returns false if the codec is not valid.
+bool SetSolutionHistory(int length, const char *codec, double fps);
+
+/// Create a history with the settings above; NULL if it is disabled.
+SolutionHistory *NewSolutionHistory();
+
+/// Playback rate of the histories, in frames per second.
+double GetSolutionHistoryFPS();
+
+#endif
@@ -0,0 +1,291 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "visual.hpp"
+
+using namespace std;
+
+// Inputs shorter than this are parsed by the calling thread
+static const size_t min_chunk_size = 1 << 20;
+
+static inline bool IsSpace(char c)
+{
+   return (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' ||
+           c == '\f');
+}
+
+// Data shared by the tasks in ParseNumbers(). The chunks begin at white space
+// (or at the beginning of the input), so that no number spans two chunks.
+struct ParseNumbersData
+{
+   Array<const char *> chunk; // chunk i is [chunk[i], chunk[i+1])
+   Array<int> count;          // numbers in chunk i, then index of its first
+   Array<const char *> last;  // end of the last number parsed in chunk i
+   int first;                 // first chunk counted by CountChunk()
+   int n;
+   double *v;
+   int error;
+};
+
+static const char *NextToken(const char *p, const char *end,
+                             const char *&tok_end)
+{
+   while (p < end && IsSpace(*p)) { p++; }
+   tok_end = p;
+   while (tok_end < end && !IsSpace(*tok_end)) { tok_end++; }
+   return p;
+}
+
+// Count the numbers in chunk first+i
+static void CountChunk(int i, void *data)
+{
+   ParseNumbersData &pd = *(ParseNumbersData *)data;
+   i += pd.first;
+   const char *p = pd.chunk[i], *end = pd.chunk[i+1], *tok_end;
+   int count = 0;
+   while ((p = NextToken(p, end, tok_end)) < end)
+   {
+      count++;
+      p = tok_end;
+   }
+   pd.count[i] = count;
+}
+
+// Parse a number with strtod(), which, in the "C" locale used by GLVis, is
+// much faster than the iostream operator>>. The token is copied, since the
+// mapped input is not null-terminated.
+static bool ParseNumber(const char *tok, const char *tok_end, double &x)
+{
+   char buf[64];
+   const size_t len = tok_end - tok;
+   if (len >= sizeof(buf))
+   {
+      return false;
+   }
+   memcpy(buf, tok, len);
+   buf[len] = '\0';
+   char *num_end;
+   x = strtod(buf, &num_end);
+   return (num_end == buf + len);
+}
+
+// Parse the numbers of chunk i that are among the first n
+static void ParseChunk(int i, void *data)
+{
+   ParseNumbersData &pd = *(ParseNumbersData *)data;
+   const char *p = pd.chunk[i], *end = pd.chunk[i+1], *tok_end;
+   int k = pd.count[i];
+   while (k < pd.n && (p = NextToken(p, end, tok_end)) < end)
+   {
+      if (!ParseNumber(p, tok_end, pd.v[k]))
+      {
+         __atomic_store_n(&pd.error, 1, __ATOMIC_RELAXED);
+         return;
+      }
+      k++;
+      p = tok_end;
+   }
+   pd.last[i] = p;
+}
+
+const char *ParseNumbers(const char *begin, const char *end, int n, double *v)
+{
+   if (n <= 0)
+   {
+      return begin;
+   }
+
+   ParseNumbersData pd;
+   const size_t size = end - begin;
+   int num_chunks = 4*GetNumWorkerThreads();
+   if (size/num_chunks < min_chunk_size)
+   {
+      num_chunks = size/min_chunk_size + 1;
+   }
+   pd.chunk.SetSize(num_chunks + 1);
+   pd.chunk[0] = begin;
+   for (int i = 1; i < num_chunks; i++)
+   {
+      const char *p = begin + (size/num_chunks)*i;
+      if (p < pd.chunk[i-1])
+      {
+         p = pd.chunk[i-1];
+      }
+      while (p < end && !IsSpace(*p)) { p++; }
+      pd.chunk[i] = p;
+   }
+   pd.chunk[num_chunks] = end;
+   pd.count.SetSize(num_chunks);
+   pd.last.SetSize(num_chunks);
+   pd.n = n;
+   pd.v = v;
+   pd.error = 0;
+
+   // first pass: count the numbers in the chunks, a few chunks at a time,
+   // until the n-th number is found (the rest of the input may be other data)
+   const int round = GetNumWorkerThreads();
+   int used_chunks = 0, total = 0;
+   while (used_chunks < num_chunks && total < n)
+   {
+      pd.first = used_chunks;
+      used_chunks = pd.first + round;
+      if (used_chunks > num_chunks)
+      {
+         used_chunks = num_chunks;
+      }
+      ParallelFor(used_chunks - pd.first, CountChunk, &pd);
+      for (int i = pd.first; i < used_chunks; i++)
+      {
+         const int c = pd.count[i];
+         pd.count[i] = total;
+         total += c;
+      }
+   }
+   if (total < n)
+   {
+      return NULL;
+   }
+
+   // second pass: parse the numbers of the chunks concurrently
+   ParallelFor(used_chunks, ParseChunk, &pd);
+   if (pd.error)
+   {
+      return NULL;
+   }
+   int i = used_chunks - 1;
+   while (pd.count[i] >= n) { i--; }
+   return pd.last[i];
+}
+
+MappedInput::MappedInput(const char *filename, long offset)
+   : data(NULL), size(0), pos(NULL)
+{
+   if (offset < 0)
+   {
+      return;
+   }
+   int fd = open(filename, O_RDONLY);
+   if (fd < 0)
+   {
+      return;
+   }
+   struct stat st;
+   if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > offset)
+   {
+      void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED)
+      {
+         data = (char *)p;
+         size = st.st_size;
+      }
+   }
+   close(fd);
+   if (!data)
+   {
+      return;
+   }
+   madvise(data, size, MADV_SEQUENTIAL);
+   // gzip-compressed files are read with ifgzstream
+   if (size >= 2 && (unsigned char)data[0] == 0x1f &&
+       (unsigned char)data[1] == 0x8b)
+   {
+      return;
+   }
+   pos = data + offset;
+}
+
+bool MappedInput::SkipLine()
+{
+   if (!Good())
+   {
+      return false;
+   }
+   const char *end = data + size;
+   const char *p = (const char *)memchr(pos, '\n', end - pos);
+   pos = p ? p + 1 : end;
+   return true;
+}
+
+bool MappedInput::LoadVector(Vector &v, int n)
+{
+   if (!Good())
+   {
+      return false;
+   }
+   v.SetSize(n);
+   const char *p = ParseNumbers(pos, data + size, n, v.GetData());
+   if (!p)
+   {
+      return false;
+   }
+   pos = p;
+   return true;
+}
+
+bool MappedInput::ReadHeader(string &header)
+{
+   if (!Good())
+   {
+      return false;
+   }
+   membuf buf(const_cast<char *>(pos), data + size - pos);
+   istream is(&buf);
+   if (!ReadGridFunctionHeader(is, header))
+   {
+      return false;
+   }
+   pos = data + size - buf.in_avail();
+   return true;
+}
+
+GridFunction *MappedInput::LoadGridFunction(Mesh *mesh)
+{
+   const char *start = pos;
+   string header;
+   if (!ReadHeader(header))
+   {
+      return NULL;
+   }
+
+   // construct the grid function from the header only, then parse its values
+   GridFunction *gf = NewGridFunction(mesh, header);
+   if (gf == NULL)
+   {
+      pos = start;
+      return NULL;
+   }
+   const char *values_end =
+      ParseNumbers(pos, data + size, gf->Size(), gf->GetData());
+   if (!values_end)
+   {
+      delete gf;
+      pos = start;
+      return NULL;
+   }
+   pos = values_end;
+   return gf;
+}
+
+MappedInput::~MappedInput()
+{
+   if (data)
+   {
+      munmap(data, size);
+   }
+}
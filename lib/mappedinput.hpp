@@ -0,0 +1,61 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#ifndef GLVIS_MAPPEDINPUT
+#define GLVIS_MAPPEDINPUT
+
+#include <cstddef>
+#include <string>
+#include "mfem.hpp"
+using namespace mfem;
+
+/// Parse 'n' numbers separated by white space from the text [begin, end) into
+/// 'v'. Long inputs are split into chunks that are parsed concurrently with
+/// ParallelFor(). Returns a pointer past the last number, or NULL if the text
+/// does not start with 'n' numbers.
+const char *ParseNumbers(const char *begin, const char *end, int n, double *v);
+
+/// Read-only memory map of an uncompressed file, used to read large solutions
+/// faster than with the iostream operator>>. The reading functions return
+/// false (or NULL) on error and then the position is not changed, so that the
+/// caller can read the data from a stream instead.
+class MappedInput
+{
+private:
+   char *data;
+   size_t size;
+   const char *pos;
+
+public:
+   /// Map 'filename' and start reading at 'offset'. The input is not Good()
+   /// if the file can not be mapped, is gzip-compressed or if 'offset' < 0.
+   MappedInput(const char *filename, long offset = 0);
+
+   bool Good() const { return (pos != NULL); }
+
+   /// Skip the rest of the current line.
+   bool SkipLine();
+
+   /// Read the header of a grid function, like ReadGridFunctionHeader(); the
+   /// position is not changed if that fails.
+   bool ReadHeader(std::string &header);
+
+   /// Read 'n' values into 'v', like v.Load(is, n).
+   bool LoadVector(Vector &v, int n);
+
+   /// Read a grid function on 'mesh', like ReadGridFunction(mesh, is).
+   GridFunction *LoadGridFunction(Mesh *mesh);
+
+   ~MappedInput();
+};
+
+#endif
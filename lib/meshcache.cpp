@@ -0,0 +1,553 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+#include <stdint.h>
+#include <cstdlib>
+#include <string>
+#include <sstream>
+#include <list>
+#include <pthread.h>
+#include "meshcache.hpp"
+#include "zstream.hpp"
+
+using namespace std;
+
+struct MeshCacheEntry
+{
+   uint64_t hash;
+   string text;  // the mesh text, compared on a hit
+   Mesh *mesh;   // NULL until the text is read a second time
+   size_t bytes; // estimated memory of the text and the mesh
+   int users;    // number of threads copying the mesh
+};
+
+typedef list<MeshCacheEntry> MeshCacheList;
+
+// the most recently used entries are at the front
+static MeshCacheList mesh_cache;
+static size_t mesh_cache_bytes = 0;
+static size_t mesh_cache_max_bytes = 0; // disabled by default
+static pthread_mutex_t mesh_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Remove the least recently used entries (that are not in use) until the
+// cache fits in mesh_cache_max_bytes. Called with the mutex locked.
+static void ShrinkMeshCache()
+{
+   MeshCacheList::iterator it = mesh_cache.end();
+   while (mesh_cache_bytes > mesh_cache_max_bytes && it != mesh_cache.begin())
+   {
+      --it;
+      if (it->users == 0)
+      {
+         mesh_cache_bytes -= it->bytes;
+         delete it->mesh;
+         it = mesh_cache.erase(it);
+      }
+   }
+}
+
+void SetMeshCacheSize(size_t max_bytes)
+{
+   pthread_mutex_lock(&mesh_cache_mutex);
+   mesh_cache_max_bytes = max_bytes;
+   ShrinkMeshCache();
+   pthread_mutex_unlock(&mesh_cache_mutex);
+}
+
+// Return the entry of the mesh text 'text' with the given hash, or
+// mesh_cache.end(). Called with the mutex locked.
+static MeshCacheList::iterator FindMeshCacheEntry(uint64_t hash,
+                                                  const string &text)
+{
+   MeshCacheList::iterator it;
+   for (it = mesh_cache.begin(); it != mesh_cache.end(); ++it)
+   {
+      if (it->hash == hash && it->text == text)
+      {
+         break;
+      }
+   }
+   return it;
+}
+
+// Estimated memory of 'mesh': its vertices and nodes, and, per entity, the
+// elements, boundary elements, edges and faces with their tables
+static size_t EstimateMeshBytes(const Mesh &mesh)
+{
+   const size_t entity_bytes = 64;
+   size_t bytes = size_t(mesh.GetNV())*3*sizeof(double);
+   bytes += entity_bytes*(size_t(mesh.GetNE()) + mesh.GetNBE() +
+                          mesh.GetNEdges() + mesh.GetNFaces());
+   const GridFunction *nodes = mesh.GetNodes();
+   if (nodes)
+   {
+      // the values and the DOF tables of their space
+      bytes += 2*size_t(nodes->Size())*sizeof(double);
+   }
+   return bytes;
+}
+
+// MFEM fills its global tables of 1D points and bases (poly1d) lazily, without
+// locking, when finite element collections are constructed, so the threads
+// reading meshes and solutions construct them with this mutex locked
+static pthread_mutex_t fe_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+FiniteElementCollection *NewFECollection(const char *name)
+{
+   pthread_mutex_lock(&fe_mutex);
+   FiniteElementCollection *fec = FiniteElementCollection::New(name);
+   pthread_mutex_unlock(&fe_mutex);
+   return fec;
+}
+
+// Construct a mesh from 'is'; curved meshes construct the finite element
+// collection of their nodes, so they are read with fe_mutex locked
+static Mesh *NewMesh(istream &is, bool fix_elem_orient, bool curved)
+{
+   if (curved)
+   {
+      pthread_mutex_lock(&fe_mutex);
+   }
+   Mesh *m = new Mesh(is, 1, 0, fix_elem_orient);
+   if (curved)
+   {
+      pthread_mutex_unlock(&fe_mutex);
+   }
+   return m;
+}
+
+// Copy 'mesh', see NewMesh()
+static Mesh *CopyMesh(const Mesh &mesh)
+{
+   const bool curved = (mesh.GetNodes() != NULL);
+   if (curved)
+   {
+      pthread_mutex_lock(&fe_mutex);
+   }
+   Mesh *m = new Mesh(mesh);
+   if (curved)
+   {
+      pthread_mutex_unlock(&fe_mutex);
+   }
+   return m;
+}
+
+// 64-bit FNV-1a hash
+static uint64_t HashMeshText(const string &text, bool fix_elem_orient)
+{
+   uint64_t h = 14695981039346656037ULL;
+   for (size_t i = 0; i < text.size(); i++)
+   {
+      h = (h ^ (unsigned char)text[i]) * 1099511628211ULL;
+   }
+   // meshes read with different options are different
+   return (h ^ (fix_elem_orient ? 1 : 0)) * 1099511628211ULL;
+}
+
+// 64-bit FNV-1a hash
+static void HashBytes(uint64_t &h, const void *data, size_t size)
+{
+   const unsigned char *b = (const unsigned char *)data;
+   for (size_t i = 0; i < size; i++)
+   {
+      h = (h ^ b[i]) * 1099511628211ULL;
+   }
+}
+
+uint64_t HashMesh(Mesh *mesh)
+{
+   uint64_t h = 14695981039346656037ULL;
+   const int sdim = mesh->SpaceDimension();
+   for (int i = 0; i < mesh->GetNV(); i++)
+   {
+      HashBytes(h, mesh->GetVertex(i), sdim*sizeof(double));
+   }
+   Array<int> v;
+   for (int i = 0; i < mesh->GetNE(); i++)
+   {
+      const int geom = mesh->GetElementBaseGeometry(i);
+      mesh->GetElementVertices(i, v);
+      HashBytes(h, &geom, sizeof(int));
+      HashBytes(h, v.GetData(), v.Size()*sizeof(int));
+   }
+   const GridFunction *nodes = mesh->GetNodes();
+   if (nodes)
+   {
+      HashBytes(h, nodes->GetData(), nodes->Size()*sizeof(double));
+   }
+   return h;
+}
+
+// Read a line from 'is' and append it, with its '\n', to 'text'. The line is
+// returned without trailing white space.
+static bool GetMeshLine(istream &is, string &line, string &text)
+{
+   if (!getline(is, line))
+   {
+      return false;
+   }
+   text += line;
+   if (!is.eof())
+   {
+      text += '\n';
+   }
+   size_t end = line.find_last_not_of(" \t\r");
+   line.erase(end == string::npos ? 0 : end + 1);
+   return true;
+}
+
+// Read a line that is not empty or a comment, see GetMeshLine().
+static bool GetMeshDataLine(istream &is, string &line, string &text)
+{
+   while (GetMeshLine(is, line, text))
+   {
+      if (!line.empty() && line[0] != '#')
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+// Read the text of a mesh in the MFEM format from 'is' into 'text'. Returns
+// true if the whole mesh was read; otherwise, 'text' contains the part of the
+// stream that was consumed.
+static bool ScanMeshText(istream &is, string &text)
+{
+   static const char header[] = "MFEM mesh v1.";
+   string line;
+
+   text.clear();
+   is >> ws;
+   for (const char *h = header; *h; h++)
+   {
+      if (is.peek() != *h)
+      {
+         return false;
+      }
+      text += char(is.get());
+   }
+   if (!GetMeshLine(is, line, text))
+   {
+      return false;
+   }
+   if (line == "2")
+   {
+      while (GetMeshLine(is, line, text))
+      {
+         if (line == "mfem_mesh_end")
+         {
+            return true;
+         }
+      }
+      return false;
+   }
+   if (line != "0" && line != "1")
+   {
+      return false;
+   }
+   // the vertices are the last section
+   while (line != "vertices")
+   {
+      if (!GetMeshLine(is, line, text))
+      {
+         return false;
+      }
+   }
+   if (!GetMeshDataLine(is, line, text))
+   {
+      return false;
+   }
+   int nv = atoi(line.c_str());
+   if (!GetMeshDataLine(is, line, text) || line == "nodes")
+   {
+      // the number of node values is not known without parsing the mesh
+      return false;
+   }
+   // 'line' is the space dimension, followed by the coordinates
+   for (int i = 0; i < nv; i++)
+   {
+      if (!GetMeshDataLine(is, line, text))
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+// Parse a mesh from 'text' followed by the rest of 'is'
+static Mesh *ParseMesh(const string &text, istream &is, bool fix_elem_orient)
+{
+   // the rest of the stream was not scanned, it may contain curved nodes
+   if (text.empty())
+   {
+      return NewMesh(is, fix_elem_orient, true);
+   }
+   prefixstreambuf buf(text, is.rdbuf());
+   istream pis(&buf);
+   Mesh *m = NewMesh(pis, fix_elem_orient, true);
+   if (!pis)
+   {
+      is.setstate(ios::failbit);
+   }
+   return m;
+}
+
+// Parse the whole text of a mesh, 'text', read by ScanMeshText()
+static Mesh *ParseMeshText(const string &text, bool fix_elem_orient)
+{
+   istringstream is(text);
+   const bool curved = (text.find("\nnodes") != string::npos);
+   return NewMesh(is, fix_elem_orient, curved);
+}
+
+Mesh *ReadMesh(istream &is, bool fix_elem_orient)
+{
+   string text;
+   if (!ScanMeshText(is, text))
+   {
+      // parse the consumed text followed by the rest of the stream
+      return ParseMesh(text, is, fix_elem_orient);
+   }
+   return ParseMeshText(text, fix_elem_orient);
+}
+
+Mesh *ReadCachedMesh(istream &is, bool fix_elem_orient)
+{
+   pthread_mutex_lock(&mesh_cache_mutex);
+   const size_t max_bytes = mesh_cache_max_bytes;
+   pthread_mutex_unlock(&mesh_cache_mutex);
+   if (max_bytes == 0)
+   {
+      return ReadMesh(is, fix_elem_orient);
+   }
+
+   string text;
+   if (!ScanMeshText(is, text))
+   {
+      // parse the consumed text followed by the rest of the stream
+      return ParseMesh(text, is, fix_elem_orient);
+   }
+
+   const uint64_t hash = HashMeshText(text, fix_elem_orient);
+   pthread_mutex_lock(&mesh_cache_mutex);
+   MeshCacheList::iterator it = FindMeshCacheEntry(hash, text);
+   const bool seen = (it != mesh_cache.end());
+   if (seen)
+   {
+      mesh_cache.splice(mesh_cache.begin(), mesh_cache, it);
+   }
+   if (seen && it->mesh)
+   {
+      it->users++;
+      pthread_mutex_unlock(&mesh_cache_mutex);
+
+      Mesh *m = CopyMesh(*it->mesh);
+
+      pthread_mutex_lock(&mesh_cache_mutex);
+      it->users--;
+      ShrinkMeshCache();
+      pthread_mutex_unlock(&mesh_cache_mutex);
+      return m;
+   }
+   if (!seen && text.size() <= mesh_cache_max_bytes)
+   {
+      // the first time the text is read only the text is kept: most meshes
+      // are read once, so they are not copied
+      mesh_cache.push_front(MeshCacheEntry());
+      MeshCacheEntry &entry = mesh_cache.front();
+      entry.hash = hash;
+      entry.text = text;
+      entry.mesh = NULL;
+      entry.bytes = text.size();
+      entry.users = 0;
+      mesh_cache_bytes += entry.bytes;
+      ShrinkMeshCache();
+   }
+   pthread_mutex_unlock(&mesh_cache_mutex);
+
+   Mesh *m = ParseMeshText(text, fix_elem_orient);
+   if (!seen)
+   {
+      return m;
+   }
+
+   // the text was read before: keep a copy of the mesh, if it fits
+   Mesh *copy = CopyMesh(*m);
+   const size_t bytes = text.size() + EstimateMeshBytes(*copy);
+   pthread_mutex_lock(&mesh_cache_mutex);
+   it = FindMeshCacheEntry(hash, text);
+   if (it != mesh_cache.end() && it->mesh == NULL &&
+       bytes <= mesh_cache_max_bytes)
+   {
+      // not removed, or completed by another thread, in the meantime
+      mesh_cache_bytes += bytes - it->bytes;
+      it->mesh = copy;
+      it->bytes = bytes;
+      copy = NULL;
+      ShrinkMeshCache();
+   }
+   pthread_mutex_unlock(&mesh_cache_mutex);
+   delete copy;
+   return m;
+}
+
+Mesh *ReadSharedMesh(istream &is, bool fix_elem_orient, bool &cached)
+{
+   cached = false;
+   string text;
+   if (!ScanMeshText(is, text))
+   {
+      return ParseMesh(text, is, fix_elem_orient);
+   }
+
+   const uint64_t hash = HashMeshText(text, fix_elem_orient);
+   pthread_mutex_lock(&mesh_cache_mutex);
+   MeshCacheList::iterator it = FindMeshCacheEntry(hash, text);
+   if (it != mesh_cache.end() && it->mesh)
+   {
+      mesh_cache.splice(mesh_cache.begin(), mesh_cache, it);
+      cached = true;
+      Mesh *m = it->mesh;
+      pthread_mutex_unlock(&mesh_cache_mutex);
+      return m;
+   }
+   pthread_mutex_unlock(&mesh_cache_mutex);
+
+   // unlike ReadCachedMesh(), the mesh is kept the first time it is read
+   Mesh *m = ParseMeshText(text, fix_elem_orient);
+   const size_t bytes = text.size() + EstimateMeshBytes(*m);
+   pthread_mutex_lock(&mesh_cache_mutex);
+   it = FindMeshCacheEntry(hash, text);
+   if (it == mesh_cache.end() && bytes <= mesh_cache_max_bytes)
+   {
+      mesh_cache.push_front(MeshCacheEntry());
+      it = mesh_cache.begin();
+      it->hash = hash;
+      it->text.swap(text);
+      it->bytes = 0;
+      it->users = 0;
+   }
+   if (it != mesh_cache.end() && it->mesh == NULL &&
+       bytes <= mesh_cache_max_bytes)
+   {
+      mesh_cache_bytes += bytes - it->bytes;
+      it->mesh = m;
+      it->bytes = bytes;
+      cached = true;
+      ShrinkMeshCache();
+   }
+   pthread_mutex_unlock(&mesh_cache_mutex);
+   return m;
+}
+
+void ForgetMeshCache()
+{
+   pthread_mutex_lock(&mesh_cache_mutex);
+   // the meshes are left in memory, where they are shared with the server
+   // process, or used by the caller of ReadSharedMesh()
+   mesh_cache.clear();
+   mesh_cache_bytes = 0;
+   pthread_mutex_unlock(&mesh_cache_mutex);
+}
+
+GridFunction *NewGridFunction(Mesh *mesh, const string &header)
+{
+   // FiniteElementSpace, FiniteElementCollection: <name>, VDim: <vdim> and
+   // Ordering: <ordering>
+   istringstream hs(header);
+   string line, fec_name;
+   int vdim = 1, ordering = -1;
+   while (getline(hs, line))
+   {
+      istringstream ls(line);
+      string key;
+      ls >> key;
+      if (key == "FiniteElementCollection:")
+      {
+         ls >> fec_name;
+      }
+      else if (key == "VDim:")
+      {
+         ls >> vdim;
+      }
+      else if (key == "Ordering:")
+      {
+         ls >> ordering;
+      }
+      else if (!key.empty() && key != "FiniteElementSpace")
+      {
+         return NULL; // e.g. NURBS spaces
+      }
+   }
+   if (fec_name.empty() || vdim < 1 || (ordering != 0 && ordering != 1))
+   {
+      return NULL;
+   }
+   FiniteElementCollection *fec = NewFECollection(fec_name.c_str());
+   if (fec == NULL)
+   {
+      return NULL;
+   }
+   FiniteElementSpace *fes =
+      new FiniteElementSpace(mesh, fec, vdim, ordering);
+   GridFunction *gf = new GridFunction(fes);
+   gf->MakeOwner(fec);
+   return gf;
+}
+
+bool ReadGridFunctionHeader(istream &is, string &header)
+{
+   const int max_header_lines = 16;
+   string line;
+   header.clear();
+   is >> ws;
+   for (int l = 0; l < max_header_lines && getline(is, line); l++)
+   {
+      header += line;
+      header += '\n';
+      if (line.find("NURBS") != string::npos)
+      {
+         return false; // the values may not follow the header
+      }
+      if (line.compare(0, 9, "Ordering:") == 0)
+      {
+         return true;
+      }
+   }
+   return false;
+}
+
+GridFunction *ReadGridFunction(Mesh *mesh, istream &is)
+{
+   string header;
+   GridFunction *gf = ReadGridFunctionHeader(is, header) ?
+                      NewGridFunction(mesh, header) : NULL;
+   if (gf)
+   {
+      // only the values are parsed without fe_mutex
+      Vector &v = *gf;
+      v.Load(is, v.Size());
+      return gf;
+   }
+
+   // unknown format: read the whole grid function with fe_mutex locked
+   prefixstreambuf buf(header, is.rdbuf());
+   istream pis(&buf);
+   pthread_mutex_lock(&fe_mutex);
+   gf = new GridFunction(mesh, pis);
+   pthread_mutex_unlock(&fe_mutex);
+   if (!pis)
+   {
+      is.setstate(ios::failbit);
+   }
+   return gf;
+}
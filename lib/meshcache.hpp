@@ -0,0 +1,84 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+#ifndef GLVIS_MESHCACHE
+#define GLVIS_MESHCACHE
+
+#include <stdint.h>
+#include <iostream>
+#include <string>
+#include "mfem.hpp"
+using namespace mfem;
+
+// Cache of parsed meshes: the text of a mesh read with ReadCachedMesh() is
+// hashed and, if the same text was read recently, the mesh is copied from the
+// cache (including its edge/face tables) instead of being parsed again. The
+// first time a text is read, only the text is kept; the mesh is kept when the
+// same text is read again. The cache is disabled unless its size is set with
+// SetMeshCacheSize().
+//
+// Only meshes in the MFEM mesh format whose end can be found without parsing
+// are cached: versions v1.0 and v1.1 without curved nodes, and v1.2 (which
+// ends with "mfem_mesh_end"). Other meshes are read as usual.
+
+/// Read a mesh from 'is', like Mesh(is, 1, 0, fix_elem_orient). Thread-safe:
+/// curved meshes, whose nodes construct a finite element collection, and the
+/// meshes whose end is not found without parsing are parsed one at a time.
+Mesh *ReadMesh(std::istream &is, bool fix_elem_orient);
+
+/// Read a mesh from 'is', like ReadMesh(), using the cache of parsed meshes if
+/// it is enabled. Thread-safe.
+Mesh *ReadCachedMesh(std::istream &is, bool fix_elem_orient);
+
+/// Read a mesh from 'is', like ReadCachedMesh(), but return the cached mesh
+/// itself, which is kept the first time it is read. 'cached' is set to true if
+/// the mesh is owned by the cache, i.e. if it fits in the cache, see
+/// SetMeshCacheSize(). Used by the server to read the meshes of the sessions
+/// before they are forked: the sessions with the same mesh then share its
+/// memory (copy-on-write), and each of them owns its copy of the mesh.
+Mesh *ReadSharedMesh(std::istream &is, bool fix_elem_orient, bool &cached);
+
+/// Empty the cache of parsed meshes without deleting the meshes; called in a
+/// process forked from the server, which owns its copies of the meshes read by
+/// ReadSharedMesh() and leaves the other ones shared with the server.
+void ForgetMeshCache();
+
+/// Same as FiniteElementCollection::New(name), serialized with the other
+/// constructions of finite element collections by the functions below: MFEM
+/// fills its global tables of 1D points and bases lazily, without locking.
+FiniteElementCollection *NewFECollection(const char *name);
+
+/// Read the header of a grid function from 'is': the lines of its finite
+/// element space up to, and including, the "Ordering:" line. Returns false if
+/// that line is not found within a few lines, or for NURBS spaces, whose
+/// values may not follow the header; 'header' then has the lines read.
+bool ReadGridFunctionHeader(std::istream &is, std::string &header);
+
+/// Construct a grid function on 'mesh', with uninitialized values, from the
+/// 'header' of its finite element space (the lines up to "Ordering:").
+/// Returns NULL if the header is not in the usual format, e.g. for NURBS
+/// spaces. Thread-safe.
+GridFunction *NewGridFunction(Mesh *mesh, const std::string &header);
+
+/// Read a grid function on 'mesh' from 'is', like GridFunction(mesh, is).
+/// The finite element space is constructed with NewGridFunction() and only the
+/// values are parsed concurrently with the other threads. Thread-safe.
+GridFunction *ReadGridFunction(Mesh *mesh, std::istream &is);
+
+/// Hash of the content of 'mesh': its vertices, elements and nodes.
+uint64_t HashMesh(Mesh *mesh);
+
+/// Set the maximum total size, in bytes, of the cache of parsed meshes: the
+/// text of the cached meshes plus an estimate of their memory. Zero, the
+/// default, disables the cache.
+void SetMeshCacheSize(size_t max_bytes);
+
+#endif
@@ -0,0 +1,174 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#include <stdint.h>
+#include <string>
+#include <sstream>
+#include <pthread.h>
+#include "visual.hpp"
+
+using namespace std;
+
+// The cached projection, see ProjectVectorFEGridFunction()
+struct VectorFEProjection
+{
+   uint64_t mesh_hash;
+   int mesh_ne;
+   string fec_name;
+   int order;
+   SparseMatrix *P;
+};
+
+static VectorFEProjection vfe_proj = { 0, -1, "", -1, NULL };
+static pthread_mutex_t vfe_proj_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Build the matrix mapping the DOFs of 'fes' to the DOFs of 'd_fes': the rows
+// are the components of the vector basis functions at the L2 nodes
+static SparseMatrix *BuildProjection(const FiniteElementSpace *fes,
+                                     const FiniteElementSpace *d_fes)
+{
+   Mesh *mesh = fes->GetMesh();
+   const int ne = mesh->GetNE();
+   const int rows = d_fes->GetVSize();
+   Array<int> vdofs, d_vdofs;
+
+   int *I = new int[rows+1];
+   I[0] = 0;
+   for (int i = 0; i < ne; i++)
+   {
+      const int nd = fes->GetFE(i)->GetDof();
+      d_fes->GetElementVDofs(i, d_vdofs);
+      for (int j = 0; j < d_vdofs.Size(); j++)
+      {
+         I[d_vdofs[j]+1] = nd;
+      }
+   }
+   for (int r = 0; r < rows; r++)
+   {
+      I[r+1] += I[r];
+   }
+
+   int *J = new int[I[rows]];
+   double *A = new double[I[rows]];
+   DenseMatrix vshape;
+   for (int i = 0; i < ne; i++)
+   {
+      const FiniteElement *fe = fes->GetFE(i);
+      const IntegrationRule &ir = d_fes->GetFE(i)->GetNodes();
+      const int nd = fe->GetDof(), d_nd = ir.GetNPoints();
+      ElementTransformation *T = mesh->GetElementTransformation(i);
+      fes->GetElementVDofs(i, vdofs);
+      d_fes->GetElementVDofs(i, d_vdofs);
+      vshape.SetSize(nd, 3);
+      for (int j = 0; j < d_nd; j++)
+      {
+         T->SetIntPoint(&ir.IntPoint(j));
+         fe->CalcVShape(*T, vshape);
+         for (int c = 0; c < 3; c++)
+         {
+            const int k0 = I[d_vdofs[c*d_nd+j]];
+            for (int k = 0; k < nd; k++)
+            {
+               // negative DOFs are the ones with flipped orientation
+               const int dof = vdofs[k];
+               J[k0+k] = (dof >= 0) ? dof : -1-dof;
+               A[k0+k] = (dof >= 0) ? vshape(k, c) : -vshape(k, c);
+            }
+         }
+      }
+   }
+
+   return new SparseMatrix(I, J, A, rows, fes->GetVSize());
+}
+
+struct ProjectionMultData
+{
+   const SparseMatrix *P;
+   const double *x;
+   double *y;
+   int rows_per_chunk;
+};
+
+// y = P x for one chunk of rows, used with ParallelFor()
+static void ProjectionMultChunk(int chunk, void *data)
+{
+   ProjectionMultData &md = *(ProjectionMultData *)data;
+   const int *I = md.P->GetI(), *J = md.P->GetJ();
+   const double *A = md.P->GetData();
+   const int begin = chunk*md.rows_per_chunk;
+   int end = begin + md.rows_per_chunk;
+   if (end > md.P->Height()) { end = md.P->Height(); }
+   for (int r = begin; r < end; r++)
+   {
+      double s = 0.0;
+      for (int k = I[r]; k < I[r+1]; k++)
+      {
+         s += A[k]*md.x[J[k]];
+      }
+      md.y[r] = s;
+   }
+}
+
+GridFunction *ProjectVectorFEGridFunction(GridFunction *gf)
+{
+   if ((gf->VectorDim() == 3) && (gf->FESpace()->GetVDim() == 1))
+   {
+      int p = gf->FESpace()->GetOrder(0);
+      cout << "Switching to order " << p
+           << " discontinuous vector grid function..." << endl;
+      Mesh *mesh = gf->FESpace()->GetMesh();
+      int dim = mesh->Dimension();
+      // L2_FECollection(p, dim, 1), constructed with the other collections,
+      // see NewFECollection()
+      ostringstream d_name;
+      d_name << "L2_T1_" << dim << "D_P" << p;
+      FiniteElementCollection *d_fec = NewFECollection(d_name.str().c_str());
+      FiniteElementSpace *d_fespace =
+         new FiniteElementSpace(mesh, d_fec, 3);
+      GridFunction *d_gf = new GridFunction(d_fespace);
+      d_gf->MakeOwner(d_fec);
+
+      const uint64_t mesh_hash = HashMesh(mesh);
+      const string fec_name = gf->FESpace()->FEColl()->Name();
+
+      pthread_mutex_lock(&vfe_proj_mutex);
+      if (vfe_proj.P == NULL || vfe_proj.mesh_hash != mesh_hash ||
+          vfe_proj.mesh_ne != mesh->GetNE() || vfe_proj.fec_name != fec_name ||
+          vfe_proj.order != p || vfe_proj.P->Height() != d_gf->Size() ||
+          vfe_proj.P->Width() != gf->Size())
+      {
+         delete vfe_proj.P;
+         vfe_proj.P = BuildProjection(gf->FESpace(), d_fespace);
+         vfe_proj.mesh_hash = mesh_hash;
+         vfe_proj.mesh_ne = mesh->GetNE();
+         vfe_proj.fec_name = fec_name;
+         vfe_proj.order = p;
+      }
+
+      ProjectionMultData md;
+      md.P = vfe_proj.P;
+      md.x = gf->GetData();
+      md.y = d_gf->GetData();
+      // chunks of at least 16K rows, a few per thread for load balancing
+      const int rows = d_gf->Size();
+      int nchunks = 4*GetNumWorkerThreads();
+      md.rows_per_chunk = (rows + nchunks - 1)/nchunks;
+      if (md.rows_per_chunk < 16384) { md.rows_per_chunk = 16384; }
+      nchunks = (rows + md.rows_per_chunk - 1)/md.rows_per_chunk;
+      ParallelFor(nchunks, ProjectionMultChunk, &md);
+      pthread_mutex_unlock(&vfe_proj_mutex);
+
+      delete gf;
+      return d_gf;
+   }
+   return gf;
+}
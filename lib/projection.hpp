@@ -0,0 +1,30 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#ifndef GLVIS_PROJECTION
+#define GLVIS_PROJECTION
+
+#include "mfem.hpp"
+using namespace mfem;
+
+/// If 'gf' is a 3D vector field in a Nedelec or Raviart-Thomas space, replace
+/// it with its projection on the discontinuous (L2) vector space of the same
+/// order, deleting 'gf'; otherwise return 'gf'.
+///
+/// The projection is a sparse matrix with the values of the basis functions of
+/// 'gf' at the L2 nodes. It is kept for the next call with a grid function in
+/// the same space on the same mesh (compared by content, e.g. a mesh that is
+/// sent again with each solution), so that a stream of updates is projected
+/// with one multithreaded matrix-vector product each.
+GridFunction *ProjectVectorFEGridFunction(GridFunction *gf);
+
+#endif
@@ -0,0 +1,320 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#include <cstdio>      // snprintf
+#include <cstring>     // strchr, strlen
+#include <cctype>      // isdigit
+#include <unistd.h>    // access
+#include <sstream>
+#include "visual.hpp"
+
+using namespace std;
+
+// The words of 'header' separated by single spaces, so that headers differing
+// only in line endings or blanks compare equal.
+static string NormalizeHeader(const string &header)
+{
+   istringstream is(header);
+   string word, norm;
+   while (is >> word)
+   {
+      if (!norm.empty())
+      {
+         norm += ' ';
+      }
+      norm += word;
+   }
+   return norm;
+}
+
+SolutionSequence::SolutionSequence(const char *_pattern, int _first, int last,
+                                   int _step, Mesh *mesh, int _cache_size)
+   : pattern(_pattern), first(_first), step((_step > 0) ? _step : 1),
+     proto(NULL), num_ready(0), use_count(0), terminating(false)
+{
+   pthread_mutex_init(&mutex, NULL);
+   pthread_cond_init(&work_cond, NULL);
+   pthread_cond_init(&done_cond, NULL);
+   cache_size = (_cache_size > 1) ? _cache_size : 2;
+
+   if (!IsPattern(_pattern) || FileName(0) == FileName(1))
+   {
+      return; // not a pattern
+   }
+   if (last < 0)
+   {
+      // up to the first missing file
+      int n = 1;
+      while (access(FileName(n).c_str(), R_OK) == 0)
+      {
+         n++;
+      }
+      last = first + (n - 1)*step;
+   }
+   if (last < first)
+   {
+      return;
+   }
+   Frame empty = { EMPTY, NULL, 0 };
+   frames.assign((last - first)/step + 1, empty);
+
+   // the space of the frames, from the header of the first file
+   ifpgzstream is(FileName(0).c_str());
+   string raw_header;
+   if (!is || !ReadGridFunctionHeader(is, raw_header))
+   {
+      return;
+   }
+   header = NormalizeHeader(raw_header);
+   istringstream hs(raw_header);
+   proto = ReadGridFunction(mesh, hs);
+
+   const int num_workers = (GetNumWorkerThreads() > 1) ? 2 : 1;
+   for (int t = 0; t < num_workers; t++)
+   {
+      pthread_t tid;
+      if (pthread_create(&tid, NULL, Worker, this) == 0)
+      {
+         workers.push_back(tid);
+      }
+   }
+}
+
+bool SolutionSequence::IsPattern(const char *pattern)
+{
+   int num_conversions = 0;
+   for (const char *p = pattern; *p; p++)
+   {
+      if (*p != '%')
+      {
+         continue;
+      }
+      if (*++p == '%')
+      {
+         continue;
+      }
+      // %[flags][width][.precision]conversion, without a length modifier
+      while (*p && strchr("-+ #0", *p)) { p++; }
+      while (isdigit((unsigned char)*p)) { p++; }
+      if (*p == '.')
+      {
+         p++;
+         while (isdigit((unsigned char)*p)) { p++; }
+      }
+      if (*p == '\0' || !strchr("diouxX", *p) || ++num_conversions > 1)
+      {
+         return false;
+      }
+   }
+   return (num_conversions == 1);
+}
+
+string SolutionSequence::FileName(const char *pattern, int number)
+{
+   vector<char> name(strlen(pattern) + 64);
+   snprintf(&name[0], name.size(), pattern, number);
+   return &name[0];
+}
+
+string SolutionSequence::FileName(int k) const
+{
+   if (!IsPattern(pattern.c_str()))
+   {
+      return pattern;
+   }
+   return FileName(pattern.c_str(), first + k*step);
+}
+
+bool SolutionSequence::ReadFrame(int k, Vector &v) const
+{
+   const string fname = FileName(k);
+   const int n = proto->Size();
+   string h;
+
+   // uncompressed files are memory-mapped and their values are parsed
+   // concurrently; the stream is used if that fails
+   MappedInput mi(fname.c_str());
+   if (mi.ReadHeader(h))
+   {
+      if (NormalizeHeader(h) != header)
+      {
+         return false;
+      }
+      if (mi.LoadVector(v, n))
+      {
+         return true;
+      }
+   }
+   ifpgzstream is(fname.c_str());
+   if (!is || !ReadGridFunctionHeader(is, h) || NormalizeHeader(h) != header)
+   {
+      return false;
+   }
+   v.Load(is, n);
+   return !is.fail();
+}
+
+void SolutionSequence::Evict()
+{
+   while (num_ready > cache_size)
+   {
+      int lru = -1;
+      for (int k = 0; k < Size(); k++)
+      {
+         if (frames[k].state == READY &&
+             (lru < 0 || frames[k].last_use < frames[lru].last_use))
+         {
+            lru = k;
+         }
+      }
+      delete frames[lru].data;
+      frames[lru].data = NULL;
+      frames[lru].state = EMPTY;
+      num_ready--;
+   }
+}
+
+void *SolutionSequence::Worker(void *p)
+{
+   SolutionSequence *seq = (SolutionSequence *)p;
+   pthread_mutex_lock(&seq->mutex);
+   while (1)
+   {
+      while (!seq->terminating && seq->queue.empty())
+      {
+         pthread_cond_wait(&seq->work_cond, &seq->mutex);
+      }
+      if (seq->terminating)
+      {
+         break;
+      }
+      const int k = seq->queue.front();
+      seq->queue.pop_front();
+      Frame &f = seq->frames[k];
+      if (f.state != QUEUED)
+      {
+         continue;
+      }
+      f.state = LOADING;
+      pthread_mutex_unlock(&seq->mutex);
+
+      Vector *v = new Vector;
+      const bool ok = seq->ReadFrame(k, *v);
+
+      pthread_mutex_lock(&seq->mutex);
+      if (ok)
+      {
+         f.data = v;
+         f.state = READY;
+         f.last_use = ++seq->use_count;
+         seq->num_ready++;
+         seq->Evict();
+      }
+      else
+      {
+         delete v;
+         f.state = FAILED;
+      }
+      pthread_cond_broadcast(&seq->done_cond);
+   }
+   pthread_mutex_unlock(&seq->mutex);
+   return NULL;
+}
+
+GridFunction *SolutionSequence::NewGridFunction(int k)
+{
+   GridFunction *gf = NULL;
+   pthread_mutex_lock(&mutex);
+   Frame &f = frames[k];
+   while (f.state != READY && f.state != FAILED)
+   {
+      if (f.state == EMPTY)
+      {
+         // not prefetched (or evicted): read it before the queued frames
+         f.state = QUEUED;
+         queue.push_front(k);
+         pthread_cond_signal(&work_cond);
+      }
+      pthread_cond_wait(&done_cond, &mutex);
+   }
+   if (f.state == READY)
+   {
+      f.last_use = ++use_count;
+      gf = new GridFunction(proto->FESpace());
+      Vector &gv = *gf;
+      gv = *f.data;
+   }
+   else
+   {
+      f.state = EMPTY; // try again next time
+   }
+   pthread_mutex_unlock(&mutex);
+   return gf;
+}
+
+void SolutionSequence::Prefetch(int k, int dir)
+{
+   pthread_mutex_lock(&mutex);
+   for (size_t i = 0; i < queue.size(); i++)
+   {
+      if (frames[queue[i]].state == QUEUED)
+      {
+         frames[queue[i]].state = EMPTY;
+      }
+   }
+   queue.clear();
+   // read ahead up to half of the cache, keeping the other half for the
+   // frames behind
+   const int ahead = cache_size/2;
+   for (int j = 1; j <= ahead; j++)
+   {
+      const int i = k + j*dir;
+      if (i < 0 || i >= Size())
+      {
+         break;
+      }
+      if (frames[i].state == READY)
+      {
+         frames[i].last_use = ++use_count;
+      }
+      else if (frames[i].state == EMPTY)
+      {
+         frames[i].state = QUEUED;
+         queue.push_back(i);
+      }
+   }
+   if (!queue.empty())
+   {
+      pthread_cond_broadcast(&work_cond);
+   }
+   pthread_mutex_unlock(&mutex);
+}
+
+SolutionSequence::~SolutionSequence()
+{
+   pthread_mutex_lock(&mutex);
+   terminating = true;
+   pthread_cond_broadcast(&work_cond);
+   pthread_mutex_unlock(&mutex);
+   for (size_t t = 0; t < workers.size(); t++)
+   {
+      pthread_join(workers[t], NULL);
+   }
+   for (int k = 0; k < Size(); k++)
+   {
+      delete frames[k].data;
+   }
+   delete proto;
+   pthread_cond_destroy(&done_cond);
+   pthread_cond_destroy(&work_cond);
+   pthread_mutex_destroy(&mutex);
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#ifndef GLVIS_SEQUENCE
+#define GLVIS_SEQUENCE
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include "mfem.hpp"
+using namespace mfem;
+
+/// A sequence of solution files on the same mesh and finite element space,
+/// named with a printf-style pattern, e.g. "sol.%06d.gf", and numbered first,
+/// first+step, ..., last. The files are read by background threads ahead of
+/// the shown frame (in the direction of playback) and the DOF vectors of the
+/// recently used frames are kept in a bounded cache, so that stepping and
+/// playback in both directions do not wait for the files.
+class SolutionSequence
+{
+private:
+   enum State { EMPTY, QUEUED, LOADING, READY, FAILED };
+
+   struct Frame
+   {
+      State state;
+      Vector *data;
+      unsigned long last_use;
+   };
+
+   std::string pattern;
+   int first, step;
+   std::vector<Frame> frames;
+
+   // the grid function read from the header of the first file, which defines
+   // the space of all frames, and the normalized header
+   GridFunction *proto;
+   std::string header;
+
+   int cache_size, num_ready;
+   unsigned long use_count;
+   std::deque<int> queue; // frames to be read, in order
+
+   pthread_mutex_t mutex;
+   pthread_cond_t work_cond, done_cond;
+   std::vector<pthread_t> workers;
+   bool terminating;
+
+   bool ReadFrame(int k, Vector &v) const;
+   // drop the least recently used frames to fit in the cache; needs the mutex
+   void Evict();
+   static void *Worker(void *p);
+
+public:
+   /// Use the files of 'pattern' numbered from 'first' to 'last' (or up to the
+   /// first missing file, if 'last' < 0) on 'mesh'. Up to 'cache_size' frames
+   /// are kept in memory.
+   SolutionSequence(const char *pattern, int first, int last, int step,
+                    Mesh *mesh, int cache_size);
+
+   /// The first file was read and the pattern gives different file names.
+   bool Good() const { return (proto != NULL); }
+
+   int Size() const { return int(frames.size()); }
+
+   /// The name of the file of frame 'k'; the pattern itself if it is not
+   /// valid, see IsPattern().
+   std::string FileName(int k) const;
+
+   /// Return true if 'pattern' has exactly one conversion, of an int in
+   /// decimal, octal or hexadecimal (e.g. "%d" or "%06d"), and no other '%'
+   /// except in "%%".
+   static bool IsPattern(const char *pattern);
+
+   /// The file name given by a valid 'pattern' for 'number'.
+   static std::string FileName(const char *pattern, int number);
+
+   /// Return a new grid function with the values of frame 'k', waiting until
+   /// it has been read; NULL if the file can not be read or is on a different
+   /// space. The grid function does not own its space, which is deleted with
+   /// the sequence.
+   GridFunction *NewGridFunction(int k);
+
+   /// Read the frames following frame 'k' in direction 'dir' (+1 or -1) in
+   /// the background, cancelling the previous requests.
+   void Prefetch(int k, int dir);
+
+   ~SolutionSequence();
+};
+
+#endif
@@ -9,10 +9,15 @@
 // terms of the GNU Lesser General Public License (as published by the Free
 // Software Foundation) version 2.1 dated February 1999.
 
-#include <unistd.h>    // pipe, fcntl, write
+#include <unistd.h>    // pipe, fcntl, write, sysconf
 #include <fcntl.h>     // fcntl
 #include <cerrno>      // errno, EAGAIN
 #include <cstdio>      // perror
+#include <sched.h>     // sched_yield
+#include <cstring>     // memset
+#include <sys/time.h>  // gettimeofday
+#include <sys/socket.h>
+#include <netinet/in.h>
 #include "visual.hpp"
 
 using namespace std;
@@ -20,12 +25,14 @@ using namespace std;
 void Set_Palette(int);
 void SetMeshSolution(Mesh *mesh, GridFunction *&grid_f, bool save_coloring);
 extern const char *strings_off_on[]; // defined in vsdata.cpp
+extern int visualize; // defined in aux_vis.cpp
 
 GLVisCommand *glvis_command = NULL;
 
 GLVisCommand::GLVisCommand(
    VisualizationSceneScalarData **_vs, Mesh **_mesh, GridFunction **_grid_f,
    Vector *_sol, bool *_keep_attr, bool *_fix_elem_orient)
+   : queue_stub(NO_COMMAND)
 {
    vs        = _vs;
    mesh      = _mesh;
@@ -36,8 +43,9 @@ GLVisCommand::GLVisCommand(
 
    pthread_mutex_init(&glvis_mutex, NULL);
    pthread_cond_init(&glvis_cond, NULL);
-   num_waiting = 0;
+   num_pending_meshes = 0;
    terminating = false;
+   signaled = 0;
    if (pipe(pfd) == -1)
    {
       perror("pipe()");
@@ -46,378 +54,383 @@ GLVisCommand::GLVisCommand(
    int flag = fcntl(pfd[0], F_GETFL);
    fcntl(pfd[0], F_SETFL, flag | O_NONBLOCK);
 
-   command = NO_COMMAND;
+   queue_head = queue_tail = &queue_stub;
 
    autopause = 0;
+
+   history = NewSolutionHistory();
+   history_pos = -1;
+   history_play = false;
 }
 
-int GLVisCommand::lock()
+void GLVisCommand::Push(Command *cmd)
 {
-   int my_id;
-   pthread_mutex_lock(&glvis_mutex);
-   if (terminating)
+   cmd->next = NULL;
+   Command *prev = __atomic_exchange_n(&queue_head, cmd, __ATOMIC_ACQ_REL);
+   __atomic_store_n(&prev->next, cmd, __ATOMIC_RELEASE);
+}
+
+GLVisCommand::Command *GLVisCommand::Pop()
+{
+   Command *tail = queue_tail;
+   Command *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+   if (tail == &queue_stub)
    {
-      pthread_mutex_unlock(&glvis_mutex);
-      return -1;
+      if (next == NULL)
+      {
+         return NULL;
+      }
+      queue_tail = tail = next;
+      next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
    }
-   my_id = num_waiting++;
-   while (my_id > 0)
+   while (1)
    {
-      pthread_cond_wait(&glvis_cond, &glvis_mutex);
-      if (terminating)
+      if (next)
       {
-         num_waiting--;
-         pthread_mutex_unlock(&glvis_mutex);
-         return -1;
+         queue_tail = next;
+         return tail;
+      }
+      if (tail != __atomic_load_n(&queue_head, __ATOMIC_ACQUIRE))
+      {
+         // a producer is between its exchange and its link, wait for it
+         sched_yield();
+         next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+         continue;
+      }
+      // 'tail' is the last node: put the stub behind it, so it can be taken
+      Push(&queue_stub);
+      next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+      if (next == NULL)
+      {
+         sched_yield();
+         next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
       }
-      my_id--;
    }
-   pthread_mutex_unlock(&glvis_mutex);
-   return 0;
 }
 
-int GLVisCommand::signal()
+int GLVisCommand::Post(Command *cmd)
 {
-   char c = 's';
-   if (write(pfd[1], &c, 1) != 1)
+   if (__atomic_load_n(&terminating, __ATOMIC_ACQUIRE))
    {
+      delete cmd;
       return -1;
    }
+   Push(cmd);
+   // write one wake-up byte per batch of commands
+   if (__atomic_exchange_n(&signaled, 1, __ATOMIC_ACQ_REL) == 0)
+   {
+      char c = 's';
+      if (write(pfd[1], &c, 1) != 1)
+      {
+         return -2;
+      }
+   }
    return 0;
 }
 
-void GLVisCommand::unlock()
+void GLVisCommand::DeleteQueued()
 {
-   pthread_mutex_lock(&glvis_mutex);
-   num_waiting--;
-   if (num_waiting > 0)
+   Command *cmd;
+   while ((cmd = Pop()) != NULL)
    {
-      pthread_cond_broadcast(&glvis_cond);
+      if (cmd->type == NEW_MESH_AND_SOLUTION)
+      {
+         delete cmd->new_g;
+         delete cmd->new_m;
+      }
+      delete cmd;
    }
-   pthread_mutex_unlock(&glvis_mutex);
 }
 
 int GLVisCommand::NewMeshAndSolution(Mesh *_new_m, GridFunction *_new_g)
 {
-   if (lock() < 0)
+   // Only one mesh update may be queued at a time: this keeps the memory
+   // bounded when the data arrives faster than it can be visualized.
+   pthread_mutex_lock(&glvis_mutex);
+   while (num_pending_meshes > 0 && !terminating)
    {
-      return -1;
+      pthread_cond_wait(&glvis_cond, &glvis_mutex);
    }
-   command = NEW_MESH_AND_SOLUTION;
-   new_m = _new_m;
-   new_g = _new_g;
-   if (signal() < 0)
+   if (terminating)
    {
-      return -2;
+      pthread_mutex_unlock(&glvis_mutex);
+      return -1;
    }
-   return 0;
+   num_pending_meshes++;
+   pthread_mutex_unlock(&glvis_mutex);
+
+   Command *cmd = new Command(NEW_MESH_AND_SOLUTION);
+   cmd->new_m = _new_m;
+   cmd->new_g = _new_g;
+   return Post(cmd);
 }
 
-int GLVisCommand::Screenshot(const char *filename)
+int GLVisCommand::NewSolution(GridFunction *_new_g)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = SCREENSHOT;
-   screenshot_filename = filename;
-   if (signal() < 0)
+   return NewMeshAndSolution(NULL, _new_g);
+}
+
+Mesh *GLVisCommand::ResidentMesh()
+{
+   pthread_mutex_lock(&glvis_mutex);
+   while (num_pending_meshes > 0 && !terminating)
    {
-      return -2;
+      pthread_cond_wait(&glvis_cond, &glvis_mutex);
    }
-   return 0;
+   Mesh *m = terminating ? NULL : *mesh;
+   pthread_mutex_unlock(&glvis_mutex);
+   return m;
+}
+
+int GLVisCommand::Screenshot(const char *filename)
+{
+   Command *cmd = new Command(SCREENSHOT);
+   cmd->screenshot_filename = filename;
+   return Post(cmd);
 }
 
 int GLVisCommand::KeyCommands(const char *keys)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = KEY_COMMANDS;
-   key_commands = keys;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(KEY_COMMANDS);
+   cmd->key_commands = keys;
+   return Post(cmd);
 }
 
 int GLVisCommand::WindowSize(int w, int h)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = WINDOW_SIZE;
-   window_w = w;
-   window_h = h;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(WINDOW_SIZE);
+   cmd->window_w = w;
+   cmd->window_h = h;
+   return Post(cmd);
 }
 
 int GLVisCommand::WindowGeometry(int x, int y, int w, int h)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = WINDOW_GEOMETRY;
-   window_x = x;
-   window_y = y;
-   window_w = w;
-   window_h = h;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(WINDOW_GEOMETRY);
+   cmd->window_x = x;
+   cmd->window_y = y;
+   cmd->window_w = w;
+   cmd->window_h = h;
+   return Post(cmd);
 }
 
 int GLVisCommand::WindowTitle(const char *title)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = WINDOW_TITLE;
-   window_title = title;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(WINDOW_TITLE);
+   cmd->window_title = title;
+   return Post(cmd);
 }
 
 int GLVisCommand::PlotCaption(const char *caption)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = PLOT_CAPTION;
-   plot_caption = caption;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(PLOT_CAPTION);
+   cmd->plot_caption = caption;
+   return Post(cmd);
 }
 
 int GLVisCommand::AxisLabels(const char *a_x, const char *a_y, const char *a_z)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = AXIS_LABELS;
-   axis_label_x = a_x;
-   axis_label_y = a_y;
-   axis_label_z = a_z;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(AXIS_LABELS);
+   cmd->axis_label_x = a_x;
+   cmd->axis_label_y = a_y;
+   cmd->axis_label_z = a_z;
+   return Post(cmd);
 }
 
 int GLVisCommand::Pause()
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = PAUSE;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   return Post(new Command(PAUSE));
 }
 
 int GLVisCommand::ViewAngles(double theta, double phi)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = VIEW_ANGLES;
-   view_ang_theta = theta;
-   view_ang_phi   = phi;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(VIEW_ANGLES);
+   cmd->view_ang_theta = theta;
+   cmd->view_ang_phi   = phi;
+   return Post(cmd);
 }
 
 int GLVisCommand::Zoom(double factor)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = ZOOM;
-   zoom_factor = factor;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(ZOOM);
+   cmd->zoom_factor = factor;
+   return Post(cmd);
 }
 
 int GLVisCommand::Subdivisions(int tot, int bdr)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = SUBDIVISIONS;
-   subdiv_tot = tot;
-   subdiv_bdr = bdr;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(SUBDIVISIONS);
+   cmd->subdiv_tot = tot;
+   cmd->subdiv_bdr = bdr;
+   return Post(cmd);
 }
 
 int GLVisCommand::ValueRange(double minv, double maxv)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = VALUE_RANGE;
-   val_min = minv;
-   val_max = maxv;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(VALUE_RANGE);
+   cmd->val_min = minv;
+   cmd->val_max = maxv;
+   return Post(cmd);
 }
 
 int GLVisCommand::SetShading(const char *shd)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = SHADING;
-   shading = shd;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(SHADING);
+   cmd->shading = shd;
+   return Post(cmd);
 }
 
 int GLVisCommand::ViewCenter(double x, double y)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = VIEW_CENTER;
-   view_center_x = x;
-   view_center_y = y;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(VIEW_CENTER);
+   cmd->view_center_x = x;
+   cmd->view_center_y = y;
+   return Post(cmd);
 }
 
 int GLVisCommand::Autoscale(const char *mode)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = AUTOSCALE;
-   autoscale_mode = mode;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(AUTOSCALE);
+   cmd->autoscale_mode = mode;
+   return Post(cmd);
 }
 
 int GLVisCommand::Palette(int pal)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = PALETTE;
-   palette = pal;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(PALETTE);
+   cmd->palette = pal;
+   return Post(cmd);
 }
 
 int GLVisCommand::Camera(const double cam[])
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = CAMERA;
+   Command *cmd = new Command(CAMERA);
    for (int i = 0; i < 9; i++)
    {
-      camera[i] = cam[i];
-   }
-   if (signal() < 0)
-   {
-      return -2;
+      cmd->camera[i] = cam[i];
    }
-   return 0;
+   return Post(cmd);
 }
 
 int GLVisCommand::Autopause(const char *mode)
 {
-   if (lock() < 0)
-   {
-      return -1;
-   }
-   command = AUTOPAUSE;
-   autopause_mode = mode;
-   if (signal() < 0)
-   {
-      return -2;
-   }
-   return 0;
+   Command *cmd = new Command(AUTOPAUSE);
+   cmd->autopause_mode = mode;
+   return Post(cmd);
 }
 
-extern GridFunction *ProjectVectorFEGridFunction(GridFunction*);
-
 int GLVisCommand::Execute()
 {
-   char c;
-   int n = read(pfd[0], &c, 1);
+   char buf[64];
+   int n = read(pfd[0], buf, sizeof(buf));
 
    if (n == -1 && errno == EAGAIN)
    {
       return 1;
    }
-   if (n != 1 || c != 's')
+   if (n <= 0)
    {
       return -1;
    }
+   // new commands posted from now on will write a new wake-up byte
+   __atomic_store_n(&signaled, 0, __ATOMIC_SEQ_CST);
+
+   int count = 0;
+   bool expose = false;
+   Command *cmd;
+   while ((cmd = Pop()) != NULL)
+   {
+      ExecuteCommand(*cmd, expose);
+      if (cmd->type == NEW_MESH_AND_SOLUTION)
+      {
+         pthread_mutex_lock(&glvis_mutex);
+         num_pending_meshes--;
+         pthread_cond_broadcast(&glvis_cond);
+         pthread_mutex_unlock(&glvis_mutex);
+      }
+      delete cmd;
+      count++;
+
+      if (visualize == 2) // the threads were stopped by the last command
+      {
+         // leave the rest of the queue for later, but keep the fd readable
+         if (__atomic_exchange_n(&signaled, 1, __ATOMIC_ACQ_REL) == 0)
+         {
+            char c = 's';
+            if (write(pfd[1], &c, 1) != 1)
+            {
+               return -1;
+            }
+         }
+         break;
+      }
+   }
+
+   if (expose)
+   {
+      MyExpose();
+   }
+
+   return (count > 0) ? 0 : 1;
+}
+
+void UpdateVisualizationScene(VisualizationSceneScalarData *vs, Mesh *new_m,
+                              GridFunction *&new_g, Vector &sol)
+{
+   if (new_m->SpaceDimension() == 1)
+   {
+      VisualizationSceneSolution1d *vss =
+         dynamic_cast<VisualizationSceneSolution1d *>(vs);
+      new_g->GetNodalValues(sol);
+      vss->NewMeshAndSolution(new_m, &sol, new_g);
+   }
+   else if (new_m->SpaceDimension() == 2)
+   {
+      if (new_g->VectorDim() == 1)
+      {
+         VisualizationSceneSolution *vss =
+            dynamic_cast<VisualizationSceneSolution *>(vs);
+         new_g->GetNodalValues(sol);
+         vss->NewMeshAndSolution(new_m, &sol, new_g);
+      }
+      else
+      {
+         VisualizationSceneVector *vsv =
+            dynamic_cast<VisualizationSceneVector *>(vs);
+         vsv->NewMeshAndSolution(*new_g);
+      }
+   }
+   else
+   {
+      if (new_g->VectorDim() == 1)
+      {
+         VisualizationSceneSolution3d *vss =
+            dynamic_cast<VisualizationSceneSolution3d *>(vs);
+         new_g->GetNodalValues(sol);
+         vss->NewMeshAndSolution(new_m, &sol, new_g);
+      }
+      else
+      {
+         new_g = ProjectVectorFEGridFunction(new_g);
+         VisualizationSceneVector3d *vss =
+            dynamic_cast<VisualizationSceneVector3d *>(vs);
+         vss->NewMeshAndSolution(new_m, new_g);
+      }
+   }
+}
 
-   switch (command)
+void GLVisCommand::ExecuteCommand(Command &cmd, bool &expose)
+{
+   switch (cmd.type)
    {
       case NO_COMMAND:
          break;
 
       case NEW_MESH_AND_SOLUTION:
       {
+         // without a mesh, this is a solution-only update on the current mesh
+         Mesh *new_m = cmd.new_m ? cmd.new_m : *mesh;
+         GridFunction *new_g = cmd.new_g;
          double mesh_range = -1.0;
          if (new_g == NULL)
          {
@@ -427,55 +440,44 @@ int GLVisCommand::Execute()
          if (new_m->SpaceDimension() == (*mesh)->SpaceDimension() &&
              new_g->VectorDim() == (*grid_f)->VectorDim())
          {
-            if (new_m->SpaceDimension() == 2)
-            {
-               if (new_g->VectorDim() == 1)
-               {
-                  VisualizationSceneSolution *vss =
-                     dynamic_cast<VisualizationSceneSolution *>(*vs);
-                  new_g->GetNodalValues(*sol);
-                  vss->NewMeshAndSolution(new_m, sol, new_g);
-               }
-               else
-               {
-                  VisualizationSceneVector *vsv =
-                     dynamic_cast<VisualizationSceneVector *>(*vs);
-                  vsv->NewMeshAndSolution(*new_g);
-               }
-            }
-            else
+            if (history && history->Size() == 0)
             {
-               if (new_g->VectorDim() == 1)
-               {
-                  VisualizationSceneSolution3d *vss =
-                     dynamic_cast<VisualizationSceneSolution3d *>(*vs);
-                  new_g->GetNodalValues(*sol);
-                  vss->NewMeshAndSolution(new_m, sol, new_g);
-               }
-               else
-               {
-                  new_g = ProjectVectorFEGridFunction(new_g);
-                  VisualizationSceneVector3d *vss =
-                     dynamic_cast<VisualizationSceneVector3d *>(*vs);
-                  vss->NewMeshAndSolution(new_m, new_g);
-               }
+               // the initial solution
+               history->Add(*mesh, **grid_f, false);
             }
+            UpdateVisualizationScene(*vs, new_m, new_g, *sol);
             if (mesh_range > 0.0)
             {
                (*vs)->SetValueRange(-mesh_range, mesh_range);
             }
             delete (*grid_f);
             *grid_f = new_g;
-            delete (*mesh);
-            *mesh = new_m;
+            const bool same_mesh = (new_m == *mesh);
+            if (!same_mesh)
+            {
+               delete (*mesh);
+               *mesh = new_m;
+            }
+            if (history)
+            {
+               history->Add(*mesh, **grid_f, same_mesh);
+               history_pos = -1;
+               if (history_play)
+               {
+                  ToggleHistoryPlayback();
+               }
+            }
 
-            (*vs)->Draw();
+            expose = true;
          }
          else
          {
             cout << "Stream: field type does not match!" << endl;
             delete new_g;
-            delete new_m;
+            if (new_m != *mesh)
+            {
+               delete new_m;
+            }
          }
          if (autopause)
          {
@@ -487,66 +489,83 @@ int GLVisCommand::Execute()
 
       case SCREENSHOT:
       {
+         // the screenshot must include the effect of the preceding commands
+         if (expose)
+         {
+            MyExpose();
+            expose = false;
+         }
          cout << "Command: screenshot: " << flush;
-         if (::Screenshot(screenshot_filename.c_str(), true))
+         if (::Screenshot(cmd.screenshot_filename.c_str(), true))
          {
-            cout << "Screenshot(" << screenshot_filename << ") failed." << endl;
+            cout << "Screenshot(" << cmd.screenshot_filename << ") failed."
+                 << endl;
          }
          else
          {
-            cout << "-> " << screenshot_filename << endl;
+            cout << "-> " << cmd.screenshot_filename << endl;
          }
          break;
       }
 
       case KEY_COMMANDS:
       {
-         cout << "Command: keys: '" << key_commands << "'" << endl;
-         // SendKeySequence(key_commands.c_str());
-         CallKeySequence(key_commands.c_str());
-         MyExpose();
+         cout << "Command: keys: '" << cmd.key_commands << "'" << endl;
+         // keys like 'S' (screenshot) act on the window as drawn, which must
+         // include the effect of the preceding commands
+         if (expose)
+         {
+            MyExpose();
+            expose = false;
+         }
+         // SendKeySequence(cmd.key_commands.c_str());
+         CallKeySequence(cmd.key_commands.c_str());
+         expose = true;
          break;
       }
 
       case WINDOW_SIZE:
       {
-         cout << "Command: window_size: " << window_w << " x " << window_h << endl;
-         ResizeWindow(window_w, window_h);
+         cout << "Command: window_size: " << cmd.window_w << " x "
+              << cmd.window_h << endl;
+         ResizeWindow(cmd.window_w, cmd.window_h);
          break;
       }
 
       case WINDOW_GEOMETRY:
       {
          cout << "Command: window_geometry: "
-              << "@(" << window_x << "," << window_y << ") "
-              << window_w << " x " << window_h << endl;
-         MoveResizeWindow(window_x, window_y, window_w, window_h);
+              << "@(" << cmd.window_x << "," << cmd.window_y << ") "
+              << cmd.window_w << " x " << cmd.window_h << endl;
+         MoveResizeWindow(cmd.window_x, cmd.window_y,
+                          cmd.window_w, cmd.window_h);
          break;
       }
 
       case WINDOW_TITLE:
       {
-         cout << "Command: window_title: " << window_title << endl;
-         SetWindowTitle(window_title.c_str());
+         cout << "Command: window_title: " << cmd.window_title << endl;
+         SetWindowTitle(cmd.window_title.c_str());
          break;
       }
 
       case PLOT_CAPTION:
       {
-         cout << "Command: plot_caption: " << plot_caption << endl;
-         ::plot_caption = plot_caption;
+         cout << "Command: plot_caption: " << cmd.plot_caption << endl;
+         ::plot_caption = cmd.plot_caption;
          (*vs)->UpdateCaption(); // turn on or off the caption
-         MyExpose();
+         expose = true;
          break;
       }
 
       case AXIS_LABELS:
       {
-         cout << "Command: axis_labels: '" << axis_label_x << "' '"
-              << axis_label_y << "' '" << axis_label_z << "'" << endl;
-         (*vs)->SetAxisLabels(axis_label_x.c_str(), axis_label_y.c_str(),
-                              axis_label_z.c_str());
-         MyExpose();
+         cout << "Command: axis_labels: '" << cmd.axis_label_x << "' '"
+              << cmd.axis_label_y << "' '" << cmd.axis_label_z << "'" << endl;
+         (*vs)->SetAxisLabels(cmd.axis_label_x.c_str(),
+                              cmd.axis_label_y.c_str(),
+                              cmd.axis_label_z.c_str());
+         expose = true;
          break;
       }
 
@@ -559,36 +578,36 @@ int GLVisCommand::Execute()
 
       case VIEW_ANGLES:
       {
-         cout << "Command: view: " << view_ang_theta << ' ' << view_ang_phi
-              << endl;
-         (*vs)->SetView(view_ang_theta, view_ang_phi);
-         MyExpose();
+         cout << "Command: view: " << cmd.view_ang_theta << ' '
+              << cmd.view_ang_phi << endl;
+         (*vs)->SetView(cmd.view_ang_theta, cmd.view_ang_phi);
+         expose = true;
          break;
       }
 
       case ZOOM:
       {
-         cout << "Command: zoom: " << zoom_factor << endl;
-         (*vs)->Zoom(zoom_factor);
-         MyExpose();
+         cout << "Command: zoom: " << cmd.zoom_factor << endl;
+         (*vs)->Zoom(cmd.zoom_factor);
+         expose = true;
          break;
       }
 
       case SUBDIVISIONS:
       {
          cout << "Command: subdivisions: " << flush;
-         (*vs)->SetRefineFactors(subdiv_tot, subdiv_bdr);
-         cout << subdiv_tot << ' ' << subdiv_bdr << endl;
-         MyExpose();
+         (*vs)->SetRefineFactors(cmd.subdiv_tot, cmd.subdiv_bdr);
+         cout << cmd.subdiv_tot << ' ' << cmd.subdiv_bdr << endl;
+         expose = true;
          break;
       }
 
       case VALUE_RANGE:
       {
          cout << "Command: valuerange: " << flush;
-         (*vs)->SetValueRange(val_min, val_max);
-         cout << val_min << ' ' << val_max << endl;
-         MyExpose();
+         (*vs)->SetValueRange(cmd.val_min, cmd.val_max);
+         cout << cmd.val_min << ' ' << cmd.val_max << endl;
+         expose = true;
          break;
       }
 
@@ -596,27 +615,27 @@ int GLVisCommand::Execute()
       {
          cout << "Command: shading: " << flush;
          int s = -1;
-         if (shading == "flat")
+         if (cmd.shading == "flat")
          {
             s = 0;
          }
-         else if (shading == "smooth")
+         else if (cmd.shading == "smooth")
          {
             s = 1;
          }
-         else if (shading == "cool")
+         else if (cmd.shading == "cool")
          {
             s = 2;
          }
          if (s != -1)
          {
             (*vs)->SetShading(s, false);
-            cout << shading << endl;
-            MyExpose();
+            cout << cmd.shading << endl;
+            expose = true;
          }
          else
          {
-            cout << shading << " ?" << endl;
+            cout << cmd.shading << " ?" << endl;
          }
          break;
       }
@@ -624,29 +643,29 @@ int GLVisCommand::Execute()
       case VIEW_CENTER:
       {
          cout << "Command: viewcenter: "
-              << view_center_x << ' ' << view_center_y << endl;
-         (*vs)->ViewCenterX = view_center_x;
-         (*vs)->ViewCenterY = view_center_y;
-         MyExpose();
+              << cmd.view_center_x << ' ' << cmd.view_center_y << endl;
+         (*vs)->ViewCenterX = cmd.view_center_x;
+         (*vs)->ViewCenterY = cmd.view_center_y;
+         expose = true;
          break;
       }
 
       case AUTOSCALE:
       {
-         cout << "Command: autoscale: " << autoscale_mode;
-         if (autoscale_mode == "off")
+         cout << "Command: autoscale: " << cmd.autoscale_mode;
+         if (cmd.autoscale_mode == "off")
          {
             (*vs)->SetAutoscale(0);
          }
-         else if (autoscale_mode == "on")
+         else if (cmd.autoscale_mode == "on")
          {
             (*vs)->SetAutoscale(1);
          }
-         else if (autoscale_mode == "value")
+         else if (cmd.autoscale_mode == "value")
          {
             (*vs)->SetAutoscale(2);
          }
-         else if (autoscale_mode == "mesh")
+         else if (cmd.autoscale_mode == "mesh")
          {
             (*vs)->SetAutoscale(3);
          }
@@ -660,13 +679,13 @@ int GLVisCommand::Execute()
 
       case PALETTE:
       {
-         cout << "Command: palette: " << palette << endl;
-         Set_Palette(palette-1);
+         cout << "Command: palette: " << cmd.palette << endl;
+         Set_Palette(cmd.palette-1);
          if (!GetUseTexture())
          {
             (*vs)->EventUpdateColors();
          }
-         MyExpose();
+         expose = true;
          break;
       }
 
@@ -675,17 +694,17 @@ int GLVisCommand::Execute()
          cout << "Command: camera: ";
          for (int i = 0; i < 9; i++)
          {
-            cout << ' ' << camera[i];
+            cout << ' ' << cmd.camera[i];
          }
          cout << endl;
-         (*vs)->cam.Set(camera);
-         MyExpose();
+         (*vs)->cam.Set(cmd.camera);
+         expose = true;
          break;
       }
 
       case AUTOPAUSE:
       {
-         if (autopause_mode == "off" || autopause_mode == "0")
+         if (cmd.autopause_mode == "off" || cmd.autopause_mode == "0")
          {
             autopause = 0;
          }
@@ -706,37 +725,144 @@ int GLVisCommand::Execute()
       }
 
    }
-
-   command = NO_COMMAND;
-   unlock();
-   return 0;
 }
 
 void GLVisCommand::Terminate()
 {
-   char c;
-   int n = read(pfd[0], &c, 1);
-
    pthread_mutex_lock(&glvis_mutex);
-   terminating = true;
+   __atomic_store_n(&terminating, true, __ATOMIC_RELEASE);
+   if (num_pending_meshes > 0)
+   {
+      pthread_cond_broadcast(&glvis_cond);
+   }
    pthread_mutex_unlock(&glvis_mutex);
-   if (n == 1 && c == 's')
+
+   DeleteQueued();
+}
+
+static double GetTimeOfDay()
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
+void PlaybackTimer::Start(double _fps)
+{
+   fps = (_fps > 0.0) ? _fps : 10.0;
+   next_frame = GetTimeOfDay() + 1.0/fps;
+}
+
+bool PlaybackTimer::Due()
+{
+   const double now = GetTimeOfDay();
+   if (now < next_frame)
+   {
+      const double wait = next_frame - now;
+      usleep(useconds_t(1e6*((wait < 0.01) ? wait : 0.01)));
+      return false;
+   }
+   next_frame += 1.0/fps;
+   if (next_frame < now)
+   {
+      // drawing (or reading) is slower than the playback rate
+      next_frame = now + 1.0/fps;
+   }
+   return true;
+}
+
+static void HistoryPlaybackIdleFunc()
+{
+   if (glvis_command)
+   {
+      glvis_command->HistoryPlaybackFrame();
+   }
+}
+
+void GLVisCommand::ShowHistory(int pos)
+{
+   GridFunction *g = *grid_f;
+   history->Get(pos, *g);
+   UpdateVisualizationScene(*vs, *mesh, g, *sol);
+   *grid_f = g;
+   history_pos = (pos < history->Size()-1) ? pos : -1;
+   cout << "History: solution " << pos+1 << " of " << history->Size()
+        << " (" << history->Bytes()/1024 << " KB)" << endl;
+   SendExposeEvent();
+}
+
+void GLVisCommand::HistoryStep(int step)
+{
+   if (!history || history->Size() < 2)
    {
-      switch (command)
+      cout << "History: no previous solutions" << endl;
+      return;
+   }
+   const int newest = history->Size()-1;
+   const int cur = (history_pos < 0) ? newest : history_pos;
+   int pos = cur + step;
+   pos = (pos < 0) ? 0 : (pos > newest) ? newest : pos;
+   if (pos == cur)
+   {
+      return;
+   }
+   if (pos < newest)
+   {
+      ThreadsStop();
+   }
+   ShowHistory(pos);
+}
+
+void GLVisCommand::HistoryNewest()
+{
+   if (history_play)
+   {
+      ToggleHistoryPlayback();
+   }
+   if (history && history_pos >= 0)
+   {
+      ShowHistory(history->Size()-1);
+   }
+}
+
+void GLVisCommand::ToggleHistoryPlayback()
+{
+   if (!history_play && (!history || history->Size() < 2))
+   {
+      cout << "History: no previous solutions" << endl;
+      return;
+   }
+   history_play = !history_play;
+   if (history_play)
+   {
+      cout << "History: playback at " << GetSolutionHistoryFPS()
+           << " frames/s" << endl;
+      ThreadsStop();
+      if (history_pos < 0)
       {
-         case NEW_MESH_AND_SOLUTION:
-            delete new_g;
-            delete new_m;
-            break;
+         ShowHistory(0);
       }
-      unlock();
+      history_timer.Start(GetSolutionHistoryFPS());
+      AddIdleFunc(HistoryPlaybackIdleFunc);
    }
-   pthread_mutex_lock(&glvis_mutex);
-   if (num_waiting > 0)
+   else
    {
-      pthread_cond_broadcast(&glvis_cond);
+      cout << "History: playback stopped" << endl;
+      RemoveIdleFunc(HistoryPlaybackIdleFunc);
+   }
+}
+
+void GLVisCommand::HistoryPlaybackFrame()
+{
+   if (!history_timer.Due())
+   {
+      return;
+   }
+   ShowHistory(history_pos + 1);
+   if (history_pos < 0)
+   {
+      ToggleHistoryPlayback();
    }
-   pthread_mutex_unlock(&glvis_mutex);
 }
 
 void GLVisCommand::ToggleAutopause()
@@ -755,46 +881,465 @@ void GLVisCommand::ToggleAutopause()
 
 GLVisCommand::~GLVisCommand()
 {
-   if (num_waiting > 0)
-      cout << "\nGLVisCommand::~GLVisCommand() : num_waiting = "
-           << num_waiting << '\n' << endl;
+   // commands posted after Terminate(), before the threads were stopped
+   DeleteQueued();
+   if (history_play)
+   {
+      RemoveIdleFunc(HistoryPlaybackIdleFunc);
+   }
+   delete history;
    close(pfd[0]);
    close(pfd[1]);
    pthread_cond_destroy(&glvis_cond);
    pthread_mutex_destroy(&glvis_mutex);
 }
 
-communication_thread::communication_thread(Array<istream *> &_is)
+int GetNumWorkerThreads()
+{
+   long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+   return (ncpu > 0) ? int(ncpu) : 1;
+}
+
+struct ParallelForData
+{
+   int n, next;
+   void (*func)(int, void *);
+   void *data;
+};
+
+static void *ParallelForWorker(void *p)
+{
+   ParallelForData *pf = (ParallelForData *)p;
+   int i;
+   while ((i = __atomic_fetch_add(&pf->next, 1, __ATOMIC_RELAXED)) < pf->n)
+   {
+      pf->func(i, pf->data);
+   }
+   return NULL;
+}
+
+void ParallelFor(int n, void (*func)(int, void *), void *data,
+                 int max_threads)
+{
+   if (max_threads <= 0)
+   {
+      max_threads = GetNumWorkerThreads();
+   }
+   ParallelForData pf;
+   pf.n = n;
+   pf.next = 0;
+   pf.func = func;
+   pf.data = data;
+
+   int num_threads = (n < max_threads) ? n : max_threads;
+   Array<pthread_t> tids;
+   for (int t = 1; t < num_threads; t++)
+   {
+      pthread_t tid;
+      if (pthread_create(&tid, NULL, ParallelForWorker, &pf) != 0)
+      {
+         break; // the remaining work is done by the started threads
+      }
+      tids.Append(tid);
+   }
+   ParallelForWorker(&pf);
+   for (int t = 0; t < tids.Size(); t++)
+   {
+      pthread_join(tids[t], NULL);
+   }
+}
+
+// Data shared by the tasks in MergeGridFunctionPieces()
+struct MergeGridFunctionData
+{
+   Array<GridFunction *> &gf_array;
+   Array<int> elem_offset; // first element of every piece in the merged mesh
+   GridFunction *gf;
+   bool delete_pieces;
+
+   MergeGridFunctionData(Array<GridFunction *> &_gf_array, bool _delete)
+      : gf_array(_gf_array), elem_offset(_gf_array.Size()), gf(NULL),
+        delete_pieces(_delete) { }
+};
+
+// Copy the DOFs of piece p. The pieces do not share DOFs in the merged space,
+// since Mesh(mesh_array, num_pieces) does not identify their vertices.
+static void MergeGridFunctionPiece(int p, void *data)
+{
+   MergeGridFunctionData &md = *(MergeGridFunctionData *)data;
+   GridFunction *piece = md.gf_array[p];
+   const FiniteElementSpace *pfes = piece->FESpace();
+   const FiniteElementSpace *fes = md.gf->FESpace();
+   Array<int> pvdofs, vdofs;
+   Vector vals;
+   for (int i = 0; i < pfes->GetNE(); i++)
+   {
+      pfes->GetElementVDofs(i, pvdofs);
+      piece->GetSubVector(pvdofs, vals);
+      fes->GetElementVDofs(md.elem_offset[p] + i, vdofs);
+      md.gf->SetSubVector(vdofs, vals);
+   }
+   if (md.delete_pieces)
+   {
+      delete piece;
+      md.gf_array[p] = NULL;
+   }
+}
+
+GridFunction *MergeGridFunctionPieces(Mesh *mesh,
+                                      Array<GridFunction *> &gf_array,
+                                      bool delete_pieces)
+{
+   const int num_pieces = gf_array.Size();
+   const FiniteElementSpace *pfes = gf_array[0]->FESpace();
+   FiniteElementCollection *fec = NewFECollection(pfes->FEColl()->Name());
+   FiniteElementSpace *fes = new FiniteElementSpace(mesh, fec, pfes->GetVDim(),
+                                                    pfes->GetOrdering());
+
+   MergeGridFunctionData md(gf_array, delete_pieces);
+   md.gf = new GridFunction(fes);
+   md.gf->MakeOwner(fec);
+   int offset = 0;
+   for (int p = 0; p < num_pieces; p++)
+   {
+      md.elem_offset[p] = offset;
+      offset += gf_array[p]->FESpace()->GetNE();
+   }
+   ParallelFor(num_pieces, MergeGridFunctionPiece, &md);
+
+   return md.gf;
+}
+
+communication_thread::communication_thread(Array<istream *> &_is,
+                                           Array<Mesh *> &_mesh_pieces,
+                                           Array<GridFunction *> &_gf_pieces,
+                                           bool _mesh_1d)
    : is(_is)
 {
    new_m = NULL;
    new_g = NULL;
+   control_fd = -1;
+   control = NULL;
+
+   _mesh_pieces.Copy(mesh_pieces);
+   _mesh_pieces.DeleteAll();
+   _gf_pieces.Copy(gf_pieces);
+   _gf_pieces.DeleteAll();
+   if (gf_pieces.Size() != mesh_pieces.Size())
+   {
+      gf_pieces.SetSize(mesh_pieces.Size(), NULL);
+   }
+   mesh_1d = _mesh_1d;
+
+   running = (is.Size() > 0);
+   if (running)
+   {
+      pthread_create(&tid, NULL, communication_thread::execute, this);
+   }
+}
+
+// the stream command "control" is refused in secure sessions
+static bool control_allowed = true;
+
+void AllowControlConnections(bool allow)
+{
+   control_allowed = allow;
+}
+
+communication_thread::communication_thread(int port)
+   : is(control_is)
+{
+   new_m = NULL;
+   new_g = NULL;
+   mesh_1d = false;
+   control = NULL;
 
-   if (is.Size() > 0)
+   // listen on the loopback interface only: control connections are not
+   // authenticated
+   control_fd = socket(AF_INET, SOCK_STREAM, 0);
+   if (control_fd != -1)
+   {
+      int on = 1;
+      setsockopt(control_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+      struct sockaddr_in sa;
+      memset(&sa, 0, sizeof(sa));
+      sa.sin_family = AF_INET;
+      sa.sin_port = htons(port);
+      sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      if (bind(control_fd, (struct sockaddr *)&sa, sizeof(sa)) == -1 ||
+          listen(control_fd, 1) == -1)
+      {
+         close(control_fd);
+         control_fd = -1;
+      }
+   }
+   running = (control_fd != -1);
+   if (running)
    {
+      cout << "Control: waiting for connections on port " << port << endl;
       pthread_create(&tid, NULL, communication_thread::execute, this);
    }
+   else
+   {
+      cout << "Control: can not listen on port " << port << endl;
+   }
 }
 
 communication_thread::~communication_thread()
 {
-   if (is.Size() > 0)
+   if (running)
    {
       pthread_cancel(tid);
       pthread_join(tid, NULL);
    }
+   delete control;
 
    delete new_g;
    delete new_m;
+   DeletePieces();
+
+   if (control_fd != -1)
+   {
+      for (int i = 0; i < control_is.Size(); i++)
+      {
+         delete control_is[i];
+      }
+      close(control_fd);
+   }
+}
+
+void communication_thread::DeletePieces()
+{
+   for (int p = mesh_pieces.Size()-1; p >= 0; p--)
+   {
+      delete gf_pieces[p];
+      delete mesh_pieces[p];
+   }
+   gf_pieces.DeleteAll();
+   mesh_pieces.DeleteAll();
 }
 
 // defined in glvis.cpp
-extern void Extrude1DMeshAndSolution(Mesh **, GridFunction **, Vector *);
+extern bool Extrude1DMeshAndSolution(Mesh **, GridFunction **, Vector *);
+
+// Data shared by the tasks reading the pieces of a "parallel" update
+ParStreamData::ParStreamData(Array<std::istream *> &_is,
+                             Array<Mesh *> &_mesh_pieces,
+                             bool fix_orient, bool keep, bool _can_update)
+   : is(_is), mesh_pieces(_mesh_pieces), mesh_array(_is.Size()),
+     gf_array(_is.Size()), nproc(_is.Size()), first_rank(0),
+     header_read(false), fix_elem_orient(fix_orient), keep_attr(keep),
+     can_update(_can_update && _mesh_pieces.Size() == _is.Size()),
+     error(0), num_updates(0), num_unchanged(0)
+{
+   mesh_array = NULL;
+   gf_array = NULL;
+}
+
+bool ParStreamData::CheckSolutions(const Array<GridFunction *> &gf_pieces)
+{
+   const int n = is.Size();
+   const bool new_mesh = (num_updates + num_unchanged < n);
+   if (error || (!new_mesh && num_updates == 0))
+   {
+      return !error;
+   }
+   // the solution pieces of all ranks must be present
+   int num_gf = 0;
+   for (int p = 0; p < n; p++)
+   {
+      if (gf_array[p] || (!mesh_array[p] && gf_pieces[p]))
+      {
+         num_gf++;
+      }
+   }
+   if (num_gf > 0 && num_gf < n)
+   {
+      cout << "Stream: mixture of meshes and solutions" << endl;
+      error = 1;
+   }
+   return !error;
+}
+
+void ParStreamData::DeleteNewData()
+{
+   for (int p = mesh_array.Size()-1; p >= 0; p--)
+   {
+      delete gf_array[p];
+      delete mesh_array[p];
+   }
+   gf_array.DeleteAll();
+   mesh_array.DeleteAll();
+}
+
+void ParStreamData::ReplacePieces(Array<GridFunction *> &gf_pieces)
+{
+   const int n = is.Size();
+   if (mesh_pieces.Size() != n)
+   {
+      for (int p = mesh_pieces.Size()-1; p >= 0; p--)
+      {
+         delete gf_pieces[p];
+         delete mesh_pieces[p];
+      }
+      mesh_pieces.SetSize(n);
+      gf_pieces.SetSize(n);
+      mesh_pieces = NULL;
+      gf_pieces = NULL;
+   }
+   for (int p = 0; p < n; p++)
+   {
+      if (mesh_array[p])
+      {
+         delete gf_pieces[p];
+         delete mesh_pieces[p];
+         mesh_pieces[p] = mesh_array[p];
+         gf_pieces[p] = gf_array[p];
+      }
+      else if (gf_array[p])
+      {
+         delete gf_pieces[p];
+         gf_pieces[p] = gf_array[p];
+      }
+   }
+   gf_array.DeleteAll();
+   mesh_array.DeleteAll();
+}
+
+void ReadParStream(int i, void *data)
+{
+   ParStreamData &psd = *(ParStreamData *)data;
+   istream &isock = *psd.is[i];
+   string ident;
+   int nproc, proc = psd.first_rank + i;
+
+   if (!psd.header_read)
+   {
+      if (i > 0)
+      {
+         isock >> ident >> ws; // "parallel"
+      }
+      isock >> nproc >> proc >> ws;
+#ifdef GLVIS_DEBUG
+      cout << "connection[" << i << "]: parallel " << nproc << ' ' << proc
+           << endl;
+#endif
+      // the server stores the connection from rank 'proc' in is[proc]
+      if (!isock || nproc != psd.nproc || proc != psd.first_rank + i)
+      {
+         cout << "Stream: invalid parallel header on connection " << i
+              << endl;
+         __atomic_store_n(&psd.error, 1, __ATOMIC_RELAXED);
+         return;
+      }
+   }
+   // "solution", "update", "unchanged", "binary" or "shm"
+   isock >> ident >> ws;
+   if (ident == "update" || ident == "unchanged")
+   {
+      // solution-only update, on the mesh previously sent by this rank, or
+      // no new data from this rank
+      if (!psd.can_update)
+      {
+         cout << "Stream: no previous data for '" << ident
+              << "' on connection " << i << endl;
+         __atomic_store_n(&psd.error, 1, __ATOMIC_RELAXED);
+         return;
+      }
+      if (ident == "unchanged")
+      {
+         __atomic_add_fetch(&psd.num_unchanged, 1, __ATOMIC_RELAXED);
+         return;
+      }
+      psd.gf_array[i] = ReadGridFunction(psd.mesh_pieces[i], isock);
+      __atomic_add_fetch(&psd.num_updates, 1, __ATOMIC_RELAXED);
+      if (!isock)
+      {
+         __atomic_store_n(&psd.error, 1, __ATOMIC_RELAXED);
+      }
+      return;
+   }
+   Mesh *m = NULL;
+   GridFunction *g = NULL;
+   if (IsBinaryDataType(ident))
+   {
+      if (ReadBinaryData(ident, isock, &m, &g, psd.fix_elem_orient) ||
+          g == NULL)
+      {
+         delete g;
+         delete m;
+         __atomic_store_n(&psd.error, 1, __ATOMIC_RELAXED);
+         return;
+      }
+   }
+   else
+   {
+      m = ReadMesh(isock, psd.fix_elem_orient);
+   }
+   if (!psd.keep_attr)
+   {
+      // set element and boundary attributes to proc+1
+      for (int j = 0; j < m->GetNE(); j++)
+      {
+         m->GetElement(j)->SetAttribute(proc+1);
+      }
+      for (int j = 0; j < m->GetNBE(); j++)
+      {
+         m->GetBdrElement(j)->SetAttribute(proc+1);
+      }
+   }
+   // indexed by connection, not by rank: is[0] is the rank first_rank
+   psd.mesh_array[i] = m;
+   psd.gf_array[i] = g ? g : ReadGridFunction(psd.mesh_array[i], isock);
+   if (!isock)
+   {
+      __atomic_store_n(&psd.error, 1, __ATOMIC_RELAXED);
+   }
+}
 
 void *communication_thread::execute(void *p)
 {
    communication_thread *_this = (communication_thread *)p;
 
+   if (_this->control_fd == -1)
+   {
+      read_commands(_this);
+      return p;
+   }
+
+   // read the control connections, one at a time
+   while (1)
+   {
+      int fd = accept(_this->control_fd, NULL, NULL); // cancellation point
+      if (fd == -1)
+      {
+         if (errno == EINTR || errno == ECONNABORTED)
+         {
+            continue;
+         }
+         perror("accept()");
+         break;
+      }
+      _this->cancel_off();
+      _this->control_is.Append(new socketstream(fd, false));
+      _this->cancel_on();
+
+      int err = read_commands(_this);
+
+      _this->cancel_off();
+      delete _this->control_is[0];
+      _this->control_is.DeleteAll();
+      _this->cancel_on();
+      if (err)
+      {
+         break;
+      }
+   }
+   return p;
+}
+
+int communication_thread::read_commands(communication_thread *_this)
+{
    while (1)
    {
       *_this->is[0] >> ws; // thread cancellation point
@@ -807,13 +1352,22 @@ void *communication_thread::execute(void *p)
          break;
       }
 
-      if (_this->ident == "mesh" || _this->ident == "solution" ||
-          _this->ident == "parallel")
+      if ((_this->ident == "mesh" || _this->ident == "solution" ||
+           _this->ident == "update" || IsBinaryDataType(_this->ident) ||
+           _this->ident == "parallel" || _this->ident == "control") &&
+          _this->control_fd != -1)
+      {
+         cout << "Control: command not accepted: " << _this->ident << endl;
+         break;
+      }
+      else if (_this->ident == "mesh" || _this->ident == "solution" ||
+               _this->ident == "update" || IsBinaryDataType(_this->ident) ||
+               _this->ident == "parallel")
       {
          bool fix_elem_orient = glvis_command->FixElementOrientations();
          if (_this->ident == "mesh")
          {
-            _this->new_m = new Mesh(*_this->is[0], 1, 0, fix_elem_orient);
+            _this->new_m = ReadCachedMesh(*_this->is[0], fix_elem_orient);
             if (!(*_this->is[0]))
             {
                break;
@@ -822,73 +1376,125 @@ void *communication_thread::execute(void *p)
          }
          else if (_this->ident == "solution")
          {
-            _this->new_m = new Mesh(*_this->is[0], 1, 0, fix_elem_orient);
+            _this->new_m = ReadCachedMesh(*_this->is[0], fix_elem_orient);
             if (!(*_this->is[0]))
             {
                break;
             }
-            _this->new_g = new GridFunction(_this->new_m, *_this->is[0]);
+            _this->new_g = ReadGridFunction(_this->new_m, *_this->is[0]);
             if (!(*_this->is[0]))
             {
                break;
             }
          }
+         else if (_this->ident == "update")
+         {
+            // solution-only update on the current mesh
+            if (_this->mesh_1d)
+            {
+               cout << "Stream: solution updates are not supported for"
+                    " vector solutions on 1D meshes" << endl;
+               break;
+            }
+            Mesh *m = glvis_command->ResidentMesh();
+            if (m == NULL)
+            {
+               goto comm_terminate;
+            }
+            _this->new_g = ReadGridFunction(m, *_this->is[0]);
+            if (!(*_this->is[0]))
+            {
+               break;
+            }
+         }
+         else if (IsBinaryDataType(_this->ident))
+         {
+            if (ReadBinaryData(_this->ident, *_this->is[0], &_this->new_m,
+                               &_this->new_g, fix_elem_orient))
+            {
+               break;
+            }
+         }
          else if (_this->ident == "parallel")
          {
-            Array<Mesh *> mesh_array;
-            Array<GridFunction *> gf_array;
-            int proc, nproc, np = 0;
-            bool keep_attr = glvis_command->KeepAttrib();
-            do
+            ParStreamData psd(_this->is, _this->mesh_pieces, fix_elem_orient,
+                              glvis_command->KeepAttrib(), !_this->mesh_1d);
+            const int nproc = _this->is.Size();
+            // read the pieces from all ranks concurrently
+            ParallelFor(nproc, ReadParStream, &psd);
+            const bool new_mesh =
+               (psd.num_updates + psd.num_unchanged < nproc);
+            Mesh *m = NULL;
+            if (!psd.error && !new_mesh && psd.num_updates > 0)
             {
-               istream &isock = *_this->is[np];
-               isock >> nproc >> proc >> ws;
-#ifdef GLVIS_DEBUG
-               cout << "connection[" << np << "]: parallel " << nproc << ' '
-                    << proc << endl;
-#endif
-               isock >> _this->ident >> ws; // "solution"
-               mesh_array.SetSize(nproc);
-               gf_array.SetSize(nproc);
-               mesh_array[proc] = new Mesh(isock, 1, 0, fix_elem_orient);
-               if (!keep_attr)
+               m = glvis_command->ResidentMesh();
+               int ne = 0;
+               for (int p = 0; p < nproc; p++)
                {
-                  // set element and boundary attributes to proc+1
-                  for (int i = 0; i < mesh_array[proc]->GetNE(); i++)
-                  {
-                     mesh_array[proc]->GetElement(i)->SetAttribute(proc+1);
-                  }
-                  for (int i = 0; i < mesh_array[proc]->GetNBE(); i++)
-                  {
-                     mesh_array[proc]->GetBdrElement(i)->SetAttribute(proc+1);
-                  }
+                  ne += _this->mesh_pieces[p]->GetNE();
                }
-               gf_array[proc] = new GridFunction(mesh_array[proc], isock);
-               np++;
-               if (np == nproc)
+               if (m && m->GetNE() != ne)
+               {
+                  cout << "Stream: the solution update does not match the"
+                       " current mesh" << endl;
+                  psd.error = 1;
+               }
+            }
+            psd.CheckSolutions(_this->gf_pieces);
+            if (psd.error || (!new_mesh && psd.num_updates > 0 && m == NULL))
+            {
+               psd.DeleteNewData();
+               if (psd.error)
                {
                   break;
                }
-               *_this->is[np] >> _this->ident >> ws; // "parallel"
+               goto comm_terminate;
             }
-            while (1);
-            _this->new_m = new Mesh(mesh_array, nproc);
-            _this->new_g = new GridFunction(_this->new_m, gf_array, nproc);
 
-            for (int p = 0; p < nproc; p++)
+            // replace the pieces of the ranks that sent new data
+            psd.ReplacePieces(_this->gf_pieces);
+
+            if (new_mesh)
+            {
+               _this->new_m = new Mesh(_this->mesh_pieces, nproc);
+               if (_this->gf_pieces[0])
+               {
+                  _this->new_g = MergeGridFunctionPieces(
+                                    _this->new_m, _this->gf_pieces, false);
+               }
+            }
+            else if (psd.num_updates > 0)
             {
-               delete gf_array[nproc-1-p];
-               delete mesh_array[nproc-1-p];
+               _this->new_g =
+                  MergeGridFunctionPieces(m, _this->gf_pieces, false);
             }
-            gf_array.DeleteAll();
-            mesh_array.DeleteAll();
          }
 
          // cout << "Stream: new solution" << endl;
 
-         Extrude1DMeshAndSolution(&_this->new_m, &_this->new_g, NULL);
-
-         if (glvis_command->NewMeshAndSolution(_this->new_m, _this->new_g))
+         if (_this->new_m)
+         {
+            if (_this->ident != "parallel")
+            {
+               _this->DeletePieces();
+            }
+            // mesh-only data gets a scalar solution in the main thread, see
+            // SetMeshSolution(), so it is not extruded, as in ReadStream()
+            Vector mesh_sol;
+            _this->mesh_1d = Extrude1DMeshAndSolution(
+                                &_this->new_m, &_this->new_g,
+                                _this->new_g ? NULL : &mesh_sol);
+
+            if (glvis_command->NewMeshAndSolution(_this->new_m, _this->new_g))
+            {
+               goto comm_terminate;
+            }
+         }
+         else if (_this->new_g == NULL)
+         {
+            // all ranks sent "unchanged"
+         }
+         else if (glvis_command->NewSolution(_this->new_g))
          {
             goto comm_terminate;
          }
@@ -896,6 +1502,29 @@ void *communication_thread::execute(void *p)
          _this->new_m = NULL;
          _this->new_g = NULL;
       }
+      else if (_this->ident == "control")
+      {
+         int port, t;
+
+         *_this->is[0] >> port;
+
+         // all processors sent the command
+         for (int i = 1; i < _this->is.Size(); i++)
+         {
+            *_this->is[i] >> ws >> _this->ident; // 'control'
+            *_this->is[i] >> t;
+         }
+
+         if (!control_allowed)
+         {
+            cout << "Control: not allowed in secure sessions" << endl;
+         }
+         else
+         {
+            delete _this->control;
+            _this->control = new communication_thread(port);
+         }
+      }
       else if (_this->ident == "screenshot")
       {
          string filename;
@@ -1252,17 +1881,23 @@ void *communication_thread::execute(void *p)
    }
 
    cout << "Stream: end of input." << endl;
+   _this->close_streams();
+   return 0;
 
 comm_terminate:
-   for (int i = 0; i < _this->is.Size(); i++)
+   _this->close_streams();
+   return -1;
+}
+
+void communication_thread::close_streams()
+{
+   for (int i = 0; i < is.Size(); i++)
    {
-      socketstream *isock = dynamic_cast<socketstream *>(_this->is[i]);
+      socketstream *isock = GetSocketStream(is[i]);
       if (isock)
       {
          isock->close();
       }
    }
-   _this->cancel_on();
-
-   return p;
+   cancel_on();
 }
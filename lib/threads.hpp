@@ -14,6 +14,28 @@
 
 #include <pthread.h>
 
+class SolutionHistory;
+
+// Pacing of a playback driven by an idle function, e.g. of the solution
+// history or of a sequence of solution files
+class PlaybackTimer
+{
+private:
+   double fps;        // frames per second
+   double next_frame; // time of the next frame, in seconds
+
+public:
+   PlaybackTimer() : fps(10.0), next_frame(0.0) { }
+
+   // start the playback at 'fps' frames per second, the first frame is due
+   // after one period
+   void Start(double _fps);
+   double FPS() const { return fps; }
+   // return true if the next frame is due; otherwise, wait a little, so that
+   // the idle loop does not spin but the window remains responsive
+   bool Due();
+};
+
 class GLVisCommand
 {
 private:
@@ -27,8 +49,9 @@ private:
 
    pthread_mutex_t glvis_mutex;
    pthread_cond_t  glvis_cond;
-   int num_waiting;
+   int num_pending_meshes; // mesh updates queued, but not yet executed
    bool terminating;
+   int signaled; // a wake-up byte is pending in the pipe
    int pfd[2];  // pfd[0] -- reading, pfd[1] -- writing
 
    enum
@@ -55,38 +78,64 @@ private:
       AXIS_LABELS = 19
    };
 
-   // command to be executed
-   int command;
+   // A queued command: its type and arguments
+   struct Command
+   {
+      Command      *next;
+      int           type;
+      Mesh         *new_m;
+      GridFunction *new_g;
+      std::string   screenshot_filename;
+      std::string   key_commands;
+      int           window_x, window_y;
+      int           window_w, window_h;
+      std::string   window_title;
+      std::string   plot_caption;
+      std::string   axis_label_x;
+      std::string   axis_label_y;
+      std::string   axis_label_z;
+      double        view_ang_theta, view_ang_phi;
+      double        zoom_factor;
+      int           subdiv_tot, subdiv_bdr;
+      double        val_min, val_max;
+      std::string   shading;
+      double        view_center_x, view_center_y;
+      std::string   autoscale_mode;
+      int           palette;
+      double        camera[9];
+      std::string   autopause_mode;
+
+      Command(int _type) : next(NULL), type(_type), new_m(NULL), new_g(NULL) { }
+   };
 
-   // command arguments
-   Mesh         *new_m;
-   GridFunction *new_g;
-   std::string   screenshot_filename;
-   std::string   key_commands;
-   int           window_x, window_y;
-   int           window_w, window_h;
-   std::string   window_title;
-   std::string   plot_caption;
-   std::string   axis_label_x;
-   std::string   axis_label_y;
-   std::string   axis_label_z;
-   double        view_ang_theta, view_ang_phi;
-   double        zoom_factor;
-   int           subdiv_tot, subdiv_bdr;
-   double        val_min, val_max;
-   std::string   shading;
-   double        view_center_x, view_center_y;
-   std::string   autoscale_mode;
-   int           palette;
-   double        camera[9];
-   std::string   autopause_mode;
+   // Lock-free multiple-producer, single-consumer queue of commands. Worker
+   // threads push at 'queue_head', the main thread pops from 'queue_tail';
+   // 'queue_stub' is a permanent dummy node.
+   Command *queue_head;
+   Command *queue_tail;
+   Command  queue_stub;
 
    // internal variables
    int autopause;
 
-   int lock();
-   int signal();
-   void unlock();
+   // the previous solutions on the current mesh (NULL if disabled), see
+   // SolutionHistory; 'history_pos' is the index of the shown solution, or -1
+   // when the newest one is shown
+   SolutionHistory *history;
+   int history_pos;
+   bool history_play;
+   PlaybackTimer history_timer;
+
+   void Push(Command *cmd);
+   Command *Pop();
+   int Post(Command *cmd);
+   void DeleteQueued();
+
+   // execute a single command, 'expose' is set if the window needs redrawing
+   void ExecuteCommand(Command &cmd, bool &expose);
+
+   // show solution 'pos' of the history
+   void ShowHistory(int pos);
 
 public:
    // called by the main execution thread
@@ -103,6 +152,13 @@ public:
 
    // called by worker threads
    int NewMeshAndSolution(Mesh *_new_m, GridFunction *_new_g);
+   // solution-only update: '_new_g' is defined on the mesh returned by
+   // ResidentMesh()
+   int NewSolution(GridFunction *_new_g);
+   // wait until all queued mesh updates have been executed and return the
+   // current mesh (NULL, when terminating); the mesh remains current until the
+   // calling thread posts a new mesh
+   Mesh *ResidentMesh();
    int Screenshot(const char *filename);
    int KeyCommands(const char *keys);
    int WindowSize(int w, int h);
@@ -122,7 +178,8 @@ public:
    int Camera(const double cam[]);
    int Autopause(const char *mode);
 
-   // called by the main execution thread
+   // called by the main execution thread: execute all queued commands and
+   // redraw the window once at the end
    int Execute();
 
    // called by the main execution thread
@@ -130,18 +187,112 @@ public:
 
    void ToggleAutopause();
 
+   // called by the main execution thread: step through the history of the
+   // solutions ('step' < 0 goes back), show the newest solution, start or stop
+   // the playback of the history; stepping back stops the communication
+   // threads, so that the stream does not replace the shown solution
+   void HistoryStep(int step);
+   void HistoryNewest();
+   void ToggleHistoryPlayback();
+   // show the next frame of the playback when it is due; called from an idle
+   // function
+   void HistoryPlaybackFrame();
+
    // called by the main execution thread
    ~GLVisCommand();
 };
 
 extern GLVisCommand *glvis_command;
 
+/// Pass a new mesh and solution to the scene 'vs', which shows a solution of
+/// the same type; 'sol' receives the nodal values of scalar solutions. 3D
+/// vector FE solutions are replaced with their projection, see
+/// ProjectVectorFEGridFunction().
+void UpdateVisualizationScene(VisualizationSceneScalarData *vs, Mesh *new_m,
+                              GridFunction *&new_g, Vector &sol);
+
+/// Return the number of worker threads used by ParallelFor() by default: the
+/// number of online processors.
+int GetNumWorkerThreads();
+
+/// Call func(i, data) for all i in [0,n) using up to 'max_threads' threads
+/// (including the calling thread); with max_threads <= 0, the default number
+/// of worker threads is used. Returns when all calls have completed.
+void ParallelFor(int n, void (*func)(int, void *), void *data,
+                 int max_threads = 0);
+
+/// Data read from the streams of a block of ranks in a "parallel" update, see
+/// ReadParStream().
+struct ParStreamData
+{
+   Array<std::istream *> &is;  // streams of ranks [first_rank, +is.Size())
+   Array<Mesh *> &mesh_pieces; // previous meshes of the ranks
+   // new data: NULL for the ranks that did not send a mesh/solution
+   Array<Mesh *> mesh_array;
+   Array<GridFunction *> gf_array;
+   int nproc, first_rank; // total number of ranks, rank of is[0]
+   bool header_read;      // the headers "parallel nproc proc" were read
+   bool fix_elem_orient, keep_attr, can_update;
+   int error, num_updates, num_unchanged;
+
+   ParStreamData(Array<std::istream *> &_is, Array<Mesh *> &_mesh_pieces,
+                 bool fix_orient, bool keep, bool _can_update);
+
+   /// Check that either all or none of the ranks have a solution, given the
+   /// previous solution pieces; sets 'error' otherwise.
+   bool CheckSolutions(const Array<GridFunction *> &gf_pieces);
+
+   /// Delete the new data, e.g. after an error.
+   void DeleteNewData();
+
+   /// Replace the pieces of the ranks that sent new data.
+   void ReplacePieces(Array<GridFunction *> &gf_pieces);
+};
+
+/// Read the mesh and the solution sent by one rank, is[i], in a "parallel"
+/// update; 'data' is a ParStreamData. The keyword "parallel" has already been
+/// read from the first stream. Used with ParallelFor().
+void ReadParStream(int i, void *data);
+
+/// Merge the pieces of a grid function, defined on the meshes that were merged
+/// into 'mesh' with Mesh(mesh_array, num_pieces), like GridFunction(mesh,
+/// gf_array, num_pieces), but copying the pieces concurrently. If
+/// 'delete_pieces' is true, every piece is deleted (and set to NULL in
+/// 'gf_array') as soon as it has been copied.
+GridFunction *MergeGridFunctionPieces(Mesh *mesh,
+                                      Array<GridFunction *> &gf_array,
+                                      bool delete_pieces = true);
+
+/// Allow or refuse the stream command "control". Control connections are
+/// plain connections that any local user can open, so the server refuses them
+/// in secure sessions, whose clients must authenticate.
+void AllowControlConnections(bool allow);
+
 class communication_thread
 {
 private:
    // streams to read data from
    Array<std::istream *> &is;
 
+   // the meshes and solutions sent by the ranks of a parallel stream, merged
+   // into the current mesh and solution; kept for the updates that contain
+   // only the solution, or no data, from some ranks
+   Array<Mesh *> mesh_pieces;
+   Array<GridFunction *> gf_pieces;
+   // the current mesh was extruded from a 1D mesh (solution-only updates are
+   // not supported in this case)
+   bool mesh_1d;
+
+   void DeletePieces();
+
+   // control connections (see the stream command "control") are accepted on
+   // 'control_fd' and read through 'control_is'; control_fd is -1 for the
+   // thread reading the data streams
+   int control_fd;
+   Array<std::istream *> control_is;
+   // the thread reading the control connections requested by this thread
+   communication_thread *control;
+
    // data that may be dynamically allocated by the thread
    Mesh *new_m;
    GridFunction *new_g;
@@ -149,6 +300,7 @@ private:
 
    // thread id
    pthread_t tid;
+   bool running;
 
    static void cancel_off()
    {
@@ -160,10 +312,22 @@ private:
       pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
    }
 
+   // read and execute the commands from 'is' until the end of the input;
+   // returns -1 if GLVisCommand is terminating
+   static int read_commands(communication_thread *_this);
+   void close_streams();
+
    static void *execute(void *);
 
 public:
-   communication_thread(Array<std::istream *> &_is);
+   // takes ownership of the meshes and grid functions in '_mesh_pieces' and
+   // '_gf_pieces' (the arrays are emptied)
+   communication_thread(Array<std::istream *> &_is, Array<Mesh *> &_mesh_pieces,
+                        Array<GridFunction *> &_gf_pieces, bool _mesh_1d);
+
+   // accept control connections from the local host on the given port; the
+   // control connections accept all commands except mesh and solution data
+   communication_thread(int port);
 
    ~communication_thread();
 };
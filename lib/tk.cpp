@@ -266,6 +266,8 @@ void tkCloseWindow(void)
         XFree((char *)visualInfo);
         XCloseDisplay(display);
         display = 0;
+        context = 0;
+        visualInfo = 0;
 
         ExposeFunc = 0;
         ReshapeFunc = 0;
@@ -564,6 +566,11 @@ static GLenum DoNextEvent(void)
           case XK_Right:        key = TK_RIGHT;		break;
           case XK_Down:		key = TK_DOWN;		break;
 
+          case XK_Prior:        key = XK_Prior;         break;
+          case XK_Next:         key = XK_Next;          break;
+          case XK_Home:         key = XK_Home;          break;
+          case XK_End:          key = XK_End;           break;
+
           case XK_plus:		key = XK_plus;		break;
           case XK_minus:	key = XK_minus;		break;
           case XK_asterisk:     key = XK_asterisk;      break;
@@ -1293,13 +1300,13 @@ void tkInitDisplayMode(GLenum type)
     windInfo.type = type;
 }
 
-GLenum tkInitWindow(const char *title)
+GLenum tkInitDisplay(void)
 {
-    XSetWindowAttributes wa;
-    XSizeHints sh;
-    XEvent e;
     int erb, evb;
-    unsigned long mask;
+
+    if (context) {
+        return GL_TRUE;
+    }
 
     if (!display) {
         display = XOpenDisplay(0);
@@ -1361,6 +1368,20 @@ GLenum tkInitWindow(const char *title)
 
     windInfo.type = MakeVisualType(visualInfo);
 
+    return GL_TRUE;
+}
+
+GLenum tkInitWindow(const char *title)
+{
+    XSetWindowAttributes wa;
+    XSizeHints sh;
+    XEvent e;
+    unsigned long mask;
+
+    if (tkInitDisplay() == GL_FALSE) {
+        return GL_FALSE;
+    }
+
     if (TK_IS_INDEX(windInfo.type)) {
         if (visualInfo->class != StaticColor &&
             visualInfo->class != StaticGray) {
@@ -202,6 +202,7 @@ typedef struct _TK_RGBImageRec {
 
 extern void tkInitDisplayMode(GLenum);
 extern void tkInitPosition(int, int, int, int);
+extern GLenum tkInitDisplay(void);
 extern GLenum tkInitWindow(const char *);
 extern void tkCloseWindow(void);
 extern void tkQuit(void);
@@ -0,0 +1,125 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#include "tlsresume.hpp"
+
+#ifdef MFEM_USE_GNUTLS
+
+#include <ctime>
+
+using namespace std;
+
+GnuTLS_resumption::GnuTLS_resumption()
+   : num_handshakes(0), num_resumed(0), cpu_time(0.0)
+{
+   have_key = (gnutls_session_ticket_key_generate(&ticket_key) == 0);
+   if (!have_key)
+   {
+      cout << "GnuTLS: could not create the session ticket key;"
+           " session resumption is disabled." << endl;
+   }
+   pthread_mutex_init(&mutex, NULL);
+}
+
+void GnuTLS_resumption::EnableServer(gnutls_session_t session)
+{
+   if (have_key)
+   {
+      gnutls_session_ticket_enable_server(session, &ticket_key);
+   }
+}
+
+void GnuTLS_resumption::AddHandshake(bool resumed, double cpu_seconds)
+{
+   pthread_mutex_lock(&mutex);
+   num_handshakes++;
+   num_resumed += resumed ? 1 : 0;
+   cpu_time += cpu_seconds;
+   pthread_mutex_unlock(&mutex);
+}
+
+void GnuTLS_resumption::PrintStats(ostream &out)
+{
+   pthread_mutex_lock(&mutex);
+   if (num_handshakes > 0)
+   {
+      out << "TLS handshakes: " << num_handshakes << " (" << num_resumed
+          << " resumed), CPU time: " << cpu_time << " s" << endl;
+   }
+   num_handshakes = num_resumed = 0;
+   cpu_time = 0.0;
+   pthread_mutex_unlock(&mutex);
+}
+
+GnuTLS_resumption::~GnuTLS_resumption()
+{
+   pthread_mutex_destroy(&mutex);
+   if (have_key)
+   {
+      gnutls_memset(ticket_key.data, 0, ticket_key.size);
+      gnutls_free(ticket_key.data);
+   }
+}
+
+static double ThreadCPUTime()
+{
+   timespec ts;
+   if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+   {
+      return 0.0;
+   }
+   return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+// Same steps as GnuTLS_socketbuf::start_session(), with session tickets enabled
+// before the handshake. The default priorities are used: they include TLS 1.3
+// and its ticket based resumption.
+int GnuTLS_resumable_socketbuf::attach(int sd)
+{
+   if (is_open())
+   {
+      close();
+   }
+   socket_descriptor = sd;
+   session_started = false;
+
+   const double start = ThreadCPUTime();
+
+   status.set_result(gnutls_init(&session, params.get_flags()));
+   if (!status.good()) { return sd; }
+
+   resumption.EnableServer(session);
+
+   status.set_result(gnutls_set_default_priority(session));
+   if (!status.good()) { gnutls_deinit(session); return sd; }
+
+   status.set_result(gnutls_credentials_set(session, GNUTLS_CRD_CERTIFICATE,
+                                            params.get_cred()));
+   if (!status.good()) { gnutls_deinit(session); return sd; }
+
+   // clients are authenticated by their certificates
+   gnutls_certificate_server_set_request(session, GNUTLS_CERT_REQUIRE);
+   gnutls_transport_set_int(session, socket_descriptor);
+
+   handshake();
+   if (!session_started)
+   {
+      gnutls_deinit(session);
+      return sd;
+   }
+
+   resumption.AddHandshake(gnutls_session_is_resumed(session) != 0,
+                           ThreadCPUTime() - start);
+   return sd;
+}
+
+#endif // MFEM_USE_GNUTLS
@@ -0,0 +1,72 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#ifndef GLVIS_TLSRESUME
+#define GLVIS_TLSRESUME
+
+#include <iostream>
+#include "mfem.hpp"
+using namespace mfem;
+
+#ifdef MFEM_USE_GNUTLS
+
+#include <pthread.h>
+
+// TLS session resumption for the GLVis server: the server sockets send session
+// tickets, encrypted with a key created when the server starts, so a client
+// that reconnects with a ticket (as GnuTLS clients do with
+// gnutls_session_set_data) skips the certificate exchange and its public key
+// operations. The handshakes are counted and timed.
+class GnuTLS_resumption
+{
+private:
+   gnutls_datum_t ticket_key;
+   bool have_key;
+
+   pthread_mutex_t mutex;
+   int num_handshakes, num_resumed;
+   double cpu_time; // in seconds
+
+public:
+   GnuTLS_resumption();
+
+   /// Enable session tickets in a server session, before its handshake.
+   void EnableServer(gnutls_session_t session);
+
+   /// Record a handshake. Thread-safe.
+   void AddHandshake(bool resumed, double cpu_seconds);
+
+   /// Print the handshakes recorded since the last call and reset the counts.
+   void PrintStats(std::ostream &out);
+
+   ~GnuTLS_resumption();
+};
+
+/// Server-side socket buffer whose handshakes support session resumption.
+class GnuTLS_resumable_socketbuf : public GnuTLS_socketbuf
+{
+protected:
+   GnuTLS_resumption &resumption;
+
+public:
+   GnuTLS_resumable_socketbuf(const GnuTLS_session_params &p,
+                              GnuTLS_resumption &r)
+      : GnuTLS_socketbuf(p), resumption(r) { }
+
+   /// Start a TLS session on the accepted socket 'sd', like
+   /// GnuTLS_socketbuf::attach(), with session tickets enabled.
+   virtual int attach(int sd);
+};
+
+#endif // MFEM_USE_GNUTLS
+
+#endif
@@ -19,9 +19,21 @@
 #include "aux_vis.hpp"
 #include "openglvis.hpp"
 #include "vssolution.hpp"
+#include "vssolution1d.hpp"
 #include "vssolution3d.hpp"
 #include "vsvector.hpp"
 #include "vsvector3d.hpp"
 #include "threads.hpp"
+#include "aggregator.hpp"
+#include "binstream.hpp"
+#include "filecache.hpp"
+#include "history.hpp"
+#include "mappedinput.hpp"
+#include "meshcache.hpp"
+#include "projection.hpp"
+#include "sequence.hpp"
+#include "tlsresume.hpp"
+#include "warmpool.hpp"
+#include "zstream.hpp"
 
 #endif
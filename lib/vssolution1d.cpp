@@ -0,0 +1,664 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <cmath>
+
+#include <X11/keysym.h>
+
+#include "mfem.hpp"
+using namespace mfem;
+#include "visual.hpp"
+
+using namespace std;
+
+
+VisualizationSceneSolution1d *vssol1d;
+extern GeometryRefiner GLVisGeometryRefiner;
+
+#ifdef GLVIS_ISFINITE
+extern int isfinite(double x); // defined in vssolution.cpp
+#endif
+
+// Definitions of some more keys
+
+static void Solution1dKeyHPressed()
+{
+   cout << endl
+        << "+------------------------------------+" << endl
+        << "| Keys                               |" << endl
+        << "+------------------------------------+" << endl
+        << "| a -  Displays/Hides the axes       |" << endl
+        << "| A -  Turns antialiasing on/off     |" << endl
+        << "| c -  Toggle colorbar and caption   |" << endl
+        << "| C -  Change the main plot caption  |" << endl
+        << "| e -  Displays/Hides the solution   |" << endl
+        << "| f -  Nodal/Subdivided plot         |" << endl
+        << "| g -  Toggle background             |" << endl
+        << "| h -  Displays help menu            |" << endl
+        << "| i/I  (De)refine elem. (subdivided) |" << endl
+        << "| j -  Turn on/off perspective       |" << endl
+        << "| l -  Turns on/off the light        |" << endl
+        << "| L -  Toggle logarithmic scale      |" << endl
+        << "| m -  Cycle elements/level lines    |" << endl
+        << "| p/P  Cycle through color palettes  |" << endl
+        << "| q -  Quits                         |" << endl
+        << "| r -  Reset the plot to 3D view     |" << endl
+        << "| R -  Reset the plot to 2D view     |" << endl
+        << "| s -  Turn on/off unit box scaling  |" << endl
+        << "| S -  Take snapshot/Record a movie  |" << endl
+        << "| Ctrl+p - Print to a PDF file       |" << endl
+        << "+------------------------------------+" << endl
+        << "| Function keys                      |" << endl
+        << "+------------------------------------+" << endl
+        << "| F1 - X window info and keystrokes  |" << endl
+        << "| F2 - Update colors, etc.           |" << endl
+        << "| F5 - Set level lines               |" << endl
+        << "| F6 - Palette options               |" << endl
+        << "| F7 - Manually set min/max value    |" << endl
+        << "| F8 - List of subdomains to show    |" << endl
+        << "+------------------------------------+" << endl
+        << "| Mouse                              |" << endl
+        << "+------------------------------------+" << endl
+        << "| left   btn    - Rotation           |" << endl
+        << "| middle btn    - Translation        |" << endl
+        << "| right  btn    - Scaling            |" << endl
+        << "+------------------------------------+" << endl;
+}
+
+static void KeyF8Pressed()
+{
+   int attr;
+   Array<int> attr_list(&attr, 1);
+   const Array<int> &all_attr = vssol1d->GetMesh()->attributes;
+
+   cout << "El attributes ON: ";
+   for (int i = 0; i < all_attr.Size(); i++)
+      if (vssol1d->el_attr_to_show[all_attr[i]-1])
+      {
+         cout << " " << all_attr[i];
+      }
+   cout << endl;
+
+   cout << "El attribute to toggle : " << flush;
+   cin >> attr;
+   vssol1d->ToggleAttributes(attr_list);
+   SendExposeEvent();
+}
+
+static void KeyMPressed()
+{
+   vssol1d -> ToggleDrawMesh();
+   SendExposeEvent();
+}
+
+static void KeyEPressed()
+{
+   vssol1d -> ToggleDrawElems();
+   SendExposeEvent();
+}
+
+static void KeyFPressed()
+{
+   vssol1d -> ToggleShading();
+   SendExposeEvent();
+}
+
+static void KeyiPressed()
+{
+   vssol1d -> SetRefineFactors(vssol1d -> TimesToRefine + 1, 1);
+   cout << "Subdivision factor = " << vssol1d -> TimesToRefine << endl;
+   SendExposeEvent();
+}
+
+static void KeyIPressed()
+{
+   vssol1d -> SetRefineFactors(vssol1d -> TimesToRefine - 1, 1);
+   cout << "Subdivision factor = " << vssol1d -> TimesToRefine << endl;
+   SendExposeEvent();
+}
+
+VisualizationSceneSolution1d::VisualizationSceneSolution1d(Mesh &m, Vector &s)
+{
+   mesh = &m;
+   sol = &s;
+
+   Init();
+
+   auxKeyFunc (AUX_h, Solution1dKeyHPressed);
+   auxKeyFunc (AUX_H, Solution1dKeyHPressed);
+}
+
+void VisualizationSceneSolution1d::Init()
+{
+   rsol    = NULL;
+   vssol1d = this;
+
+   drawelems = shading = 1;
+   drawmesh  = 0;
+
+   shrink = 1.0;
+   shrinkmat = 1.0;
+
+   TimesToRefine = 1;
+
+   el_attr_to_show.SetSize(mesh->attributes.Max());
+   el_attr_to_show = 1;
+
+   VisualizationSceneScalarData::Init();  // Calls FindNewBox() !!!
+
+   SetUseTexture(1);
+
+   auxKeyFunc (AUX_m, KeyMPressed);
+   auxKeyFunc (AUX_M, KeyMPressed);
+
+   auxKeyFunc (AUX_e, KeyEPressed);
+   auxKeyFunc (AUX_E, KeyEPressed);
+
+   auxKeyFunc (AUX_f, KeyFPressed);
+   auxKeyFunc (AUX_F, KeyFPressed);
+
+   auxKeyFunc (AUX_i, KeyiPressed);
+   auxKeyFunc (AUX_I, KeyIPressed);
+
+   auxKeyFunc (XK_F8, KeyF8Pressed);
+
+   displlist  = glGenLists (1);
+   linelist   = glGenLists (1);
+   lcurvelist = glGenLists (1);
+
+   Prepare();
+   PrepareLines();
+   PrepareLevelLines();
+}
+
+VisualizationSceneSolution1d::~VisualizationSceneSolution1d()
+{
+   glDeleteLists (displlist, 1);
+   glDeleteLists (linelist, 1);
+   glDeleteLists (lcurvelist, 1);
+}
+
+void VisualizationSceneSolution1d::NewMeshAndSolution(
+   Mesh *new_m, Vector *new_sol, GridFunction *new_u)
+{
+   // If the number of elements changes, recompute the refinement factor
+   if (mesh->GetNE() != new_m->GetNE())
+   {
+      mesh = new_m;
+      int ref = GetAutoRefineFactor();
+      if (TimesToRefine != ref)
+      {
+         TimesToRefine = ref;
+         cout << "Subdivision factor = " << TimesToRefine << endl;
+      }
+   }
+   mesh = new_m;
+   sol = new_sol;
+   rsol = new_u;
+
+   if (el_attr_to_show.Size() != mesh->attributes.Max())
+   {
+      el_attr_to_show.SetSize(mesh->attributes.Max());
+      el_attr_to_show = 1;
+   }
+
+   DoAutoscale(false);
+
+   Prepare();
+   PrepareLines();
+   PrepareLevelLines();
+}
+
+void VisualizationSceneSolution1d::GetRefinedValues(
+   int i, const IntegrationRule &ir, Vector &vals, DenseMatrix &tr)
+{
+   rsol->GetValues(i, ir, vals, tr);
+
+   if (logscale)
+      for (int j = 0; j < vals.Size(); j++)
+      {
+         vals(j) = _LogVal(vals(j));
+      }
+}
+
+void VisualizationSceneSolution1d::SetShading(int s, bool print)
+{
+   if (shading == s || s < 0 || s > (rsol ? 2 : 1))
+   {
+      return;
+   }
+
+   const bool rescale = (s == 2 || shading == 2);
+   shading = s;
+   if (rescale)
+   {
+      DoAutoscale(false);
+   }
+   Prepare();
+   PrepareLines();
+   PrepareLevelLines();
+
+   static const char *shading_type[3] =
+   {"nodal values", "nodal values", "subdivided elements"};
+   if (print)
+   {
+      cout << "Plot type : " << shading_type[shading] << endl;
+   }
+}
+
+void VisualizationSceneSolution1d::ToggleShading()
+{
+   // there is no flat shading of a line: toggle between 1 and 2
+   SetShading((shading == 2) ? 1 : (rsol ? 2 : 1), true);
+}
+
+void VisualizationSceneSolution1d::SetRefineFactors(int tot, int bdr)
+{
+   if (tot == TimesToRefine || tot < 1)
+   {
+      return;
+   }
+
+   TimesToRefine = tot;
+
+   if (shading == 2)
+   {
+      DoAutoscale(false);
+      Prepare();
+      PrepareLines();
+      PrepareLevelLines();
+   }
+}
+
+int VisualizationSceneSolution1d::GetAutoRefineFactor()
+{
+   // the same limit on the number of points as for the 2D surfaces
+   int ne = mesh->GetNE(), ref = 1;
+
+   while (ref < auto_ref_max && ne*(ref+1)*(ref+1) <= auto_ref_max_surf_elem)
+   {
+      ref++;
+   }
+
+   return ref;
+}
+
+void VisualizationSceneSolution1d::AutoRefine()
+{
+   int ref = GetAutoRefineFactor();
+
+   cout << "Subdivision factor = " << ref << endl;
+
+   SetRefineFactors(ref, 1);
+}
+
+void VisualizationSceneSolution1d::ToggleAttributes(Array<int> &attr_list)
+{
+   Array<int> &attr_marker = el_attr_to_show;
+
+   for (int i = 0; i < attr_list.Size(); i++)
+   {
+      int attr = attr_list[i];
+      if (attr < 1)
+      {
+         cout << "Hiding all attributes." << endl;
+         attr_marker = 0;
+      }
+      else if (attr > attr_marker.Size())
+      {
+         cout << "Showing all attributes." << endl;
+         attr_marker = 1;
+      }
+      else
+      {
+         attr_marker[attr-1] = !attr_marker[attr-1];
+      }
+   }
+   PrepareLines();
+   Prepare();
+}
+
+void VisualizationSceneSolution1d::SetNewScalingFromBox()
+{
+   // the x-range and the value range are scaled independently: to the unit
+   // square with 's', otherwise to a box with the golden ratio aspect
+   xscale = x[1]-x[0];
+   yscale = y[1]-y[0];
+   xscale = (xscale > 0.0) ? ( 1.0 / xscale ) : 1.0;
+   yscale = (yscale > 0.0) ? ( 1.0 / yscale ) : 1.0;
+   zscale = 1.0;
+   if (!scaling)
+   {
+      yscale /= ((1. + sqrt(5.)) / 2.);
+   }
+}
+
+void VisualizationSceneSolution1d::FindNewBox(double rx[], double rval[])
+{
+   int i, j;
+
+   if (shading != 2)
+   {
+      int nv = mesh -> GetNV();
+
+      rval[0] = rval[1] = (*sol)(0);
+      for (i = 1; i < sol->Size(); i++)
+      {
+         if ((*sol)(i) < rval[0]) { rval[0] = (*sol)(i); }
+         if ((*sol)(i) > rval[1]) { rval[1] = (*sol)(i); }
+      }
+      rx[0] = rx[1] = mesh->GetVertex(0)[0];
+      for (i = 1; i < nv; i++)
+      {
+         const double cx = mesh->GetVertex(i)[0];
+         if (cx < rx[0]) { rx[0] = cx; }
+         if (cx > rx[1]) { rx[1] = cx; }
+      }
+   }
+   else
+   {
+      int ne = mesh -> GetNE();
+      DenseMatrix pointmat;
+      Vector values;
+      RefinedGeometry *RefG;
+      bool log_scale = logscale;
+
+      logscale = false;
+      rx[0] = rval[0] = numeric_limits<double>::infinity();
+      rx[1] = rval[1] = -rx[0];
+      for (i = 0; i < ne; i++)
+      {
+         RefG = GLVisGeometryRefiner.Refine(mesh->GetElementBaseGeometry(i),
+                                            TimesToRefine);
+         GetRefinedValues(i, RefG->RefPts, values, pointmat);
+         for (j = 0; j < values.Size(); j++)
+         {
+            if (isfinite(pointmat(0,j)))
+            {
+               if (pointmat(0,j) < rx[0]) { rx[0] = pointmat(0,j); }
+               if (pointmat(0,j) > rx[1]) { rx[1] = pointmat(0,j); }
+            }
+            if (isfinite(values(j)))
+            {
+               if (values(j) < rval[0]) { rval[0] = values(j); }
+               if (values(j) > rval[1]) { rval[1] = values(j); }
+            }
+         }
+      }
+      logscale = log_scale;
+   }
+}
+
+void VisualizationSceneSolution1d::FindNewBox(bool prepare)
+{
+   FindNewBox(x, y);
+
+   minv = y[0];
+   maxv = y[1];
+
+   FixValueRange();
+
+   y[0] = minv;
+   y[1] = maxv;
+   z[0] = z[1] = 0.0;
+
+   SetNewScalingFromBox(); // UpdateBoundingBox minus PrepareAxes
+   UpdateValueRange(prepare);
+}
+
+void VisualizationSceneSolution1d::FindNewValueRange(bool prepare)
+{
+   double rx[2], rv[2];
+
+   FindNewBox(rx, rv);
+   minv = rv[0];
+   maxv = rv[1];
+
+   FixValueRange();
+
+   UpdateValueRange(prepare);
+}
+
+void VisualizationSceneSolution1d::FindMeshBox(bool prepare)
+{
+   double rv[2];
+
+   FindNewBox(x, rv);
+
+   UpdateBoundingBox(); // SetNewScalingFromBox plus PrepareAxes
+}
+
+void VisualizationSceneSolution1d::ToggleLogscale(bool print)
+{
+   if (logscale || LogscaleRange())
+   {
+      logscale = !logscale;
+      SetLogA();
+      SetLevelLines(minv, maxv, nl);
+      Prepare();
+      PrepareLines();
+      PrepareLevelLines();
+      if (print)
+      {
+         PrintLogscale(false);
+      }
+   }
+   else if (print)
+   {
+      PrintLogscale(true);
+   }
+}
+
+void VisualizationSceneSolution1d::UpdateValueRange(bool prepare)
+{
+   logscale = logscale && LogscaleRange();
+   SetLogA();
+   SetLevelLines(minv, maxv, nl);
+   // preserve the current box y-size
+   yscale *= (y[1]-y[0])/(maxv-minv);
+   y[0] = minv;
+   y[1] = maxv;
+   PrepareAxes();
+   if (prepare)
+   {
+      Prepare();
+      PrepareLines();
+      PrepareLevelLines();
+   }
+}
+
+void VisualizationSceneSolution1d::Prepare()
+{
+   // the values are already scaled with LogVal()
+   MySetColorLogscale = 0;
+
+   int ne = mesh -> GetNE();
+
+   glNewList (displlist, GL_COMPILE);
+   glBegin (GL_LINES);
+
+   if (shading == 2)
+   {
+      DenseMatrix pointmat;
+      Vector values;
+      RefinedGeometry *RefG;
+
+      for (int i = 0; i < ne; i++)
+      {
+         if (!el_attr_to_show[mesh->GetAttribute(i)-1]) { continue; }
+
+         RefG = GLVisGeometryRefiner.Refine(mesh->GetElementBaseGeometry(i),
+                                            TimesToRefine);
+         GetRefinedValues(i, RefG->RefPts, values, pointmat);
+         Array<int> &RG = RefG->RefGeoms;
+         for (int j = 0; j < RG.Size(); j++)
+         {
+            const double v = values(RG[j]);
+            MySetColor(v, minv, maxv);
+            glVertex3d(pointmat(0, RG[j]), v, 0.0);
+         }
+      }
+   }
+   else
+   {
+      Array<int> vertices;
+
+      for (int i = 0; i < ne; i++)
+      {
+         if (!el_attr_to_show[mesh->GetAttribute(i)-1]) { continue; }
+
+         mesh->GetElementVertices(i, vertices);
+         for (int j = 0; j < vertices.Size(); j++)
+         {
+            const double v = LogVal((*sol)(vertices[j]));
+            MySetColor(v, minv, maxv);
+            glVertex3d(mesh->GetVertex(vertices[j])[0], v, 0.0);
+         }
+      }
+   }
+
+   glEnd();
+   glEndList();
+}
+
+void VisualizationSceneSolution1d::PrepareLines()
+{
+   // short vertical marks at the end points of the elements
+   const double h = 0.01*(maxv - minv);
+   int ne = mesh -> GetNE();
+   Array<int> vertices;
+
+   glNewList (linelist, GL_COMPILE);
+   glBegin (GL_LINES);
+
+   for (int i = 0; i < ne; i++)
+   {
+      if (!el_attr_to_show[mesh->GetAttribute(i)-1]) { continue; }
+
+      if (shading == 2)
+      {
+         // the end points are among the refined points, 0 and 1
+         DenseMatrix pointmat;
+         Vector values;
+         RefinedGeometry *RefG =
+            GLVisGeometryRefiner.Refine(mesh->GetElementBaseGeometry(i),
+                                        TimesToRefine);
+         GetRefinedValues(i, RefG->RefPts, values, pointmat);
+         for (int j = 0; j < values.Size(); j++)
+         {
+            const double ip_x = RefG->RefPts.IntPoint(j).x;
+            if (ip_x == 0.0 || ip_x == 1.0)
+            {
+               glVertex3d(pointmat(0, j), values(j) - h, 0.0);
+               glVertex3d(pointmat(0, j), values(j) + h, 0.0);
+            }
+         }
+      }
+      else
+      {
+         mesh->GetElementVertices(i, vertices);
+         for (int j = 0; j < vertices.Size(); j++)
+         {
+            const double px = mesh->GetVertex(vertices[j])[0];
+            const double v = LogVal((*sol)(vertices[j]));
+            glVertex3d(px, v - h, 0.0);
+            glVertex3d(px, v + h, 0.0);
+         }
+      }
+   }
+
+   glEnd();
+   glEndList();
+}
+
+void VisualizationSceneSolution1d::PrepareLevelLines()
+{
+   glNewList (lcurvelist, GL_COMPILE);
+   glBegin (GL_LINES);
+
+   for (int k = 0; k < level.Size(); k++)
+   {
+      const double v = LogVal(level[k]);
+      glVertex3d(x[0], v, 0.0);
+      glVertex3d(x[1], v, 0.0);
+   }
+
+   glEnd();
+   glEndList();
+}
+
+void VisualizationSceneSolution1d::Draw()
+{
+   glEnable(GL_DEPTH_TEST);
+
+   Set_Background();
+   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+   // model transformation
+   ModelView();
+
+   glDisable(GL_CLIP_PLANE0);
+   glDisable(GL_LIGHTING);
+
+   // draw the solution polyline
+   if (drawelems)
+   {
+      if (GetUseTexture())
+      {
+         glEnable (GL_TEXTURE_1D);
+         glColor4d(1, 1, 1, 1);
+      }
+      glCallList(displlist);
+      if (GetUseTexture())
+      {
+         glDisable (GL_TEXTURE_1D);
+      }
+   }
+
+   Set_Black_Material();
+
+   // draw element end points or level lines
+   if (drawmesh == 1)
+   {
+      glCallList(linelist);
+   }
+   else if (drawmesh == 2)
+   {
+      glCallList(lcurvelist);
+   }
+
+   // draw axes
+   if (drawaxes)
+   {
+      glCallList(axeslist);
+      DrawCoordinateCross();
+   }
+
+   // draw colorbar
+   if (colorbar)
+   {
+      if (drawmesh == 2)
+      {
+         DrawColorBar(minv,maxv,&level);
+      }
+      else
+      {
+         DrawColorBar(minv,maxv);
+      }
+   }
+
+   glFlush();
+   auxSwapBuffers();
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#ifndef GLVIS_VSSOLUTION_1D
+#define GLVIS_VSSOLUTION_1D
+
+#include "mfem.hpp"
+using namespace mfem;
+
+// Line plot of a scalar solution on a 1D mesh: the solution is drawn as a
+// polyline in the (x, value) plane, with the value range along the y-axis.
+// With shading 2 the grid function is sampled at the points of the refined
+// segments from GLVisGeometryRefiner, otherwise the nodal values are used.
+class VisualizationSceneSolution1d : public VisualizationSceneScalarData
+{
+protected:
+   GridFunction *rsol;
+
+   int drawmesh, drawelems;
+   int displlist, linelist, lcurvelist;
+
+   void Init();
+
+   void FindNewBox(double rx[], double rval[]);
+
+   void GetRefinedValues(int i, const IntegrationRule &ir,
+                         Vector &vals, DenseMatrix &tr);
+
+   int GetAutoRefineFactor();
+
+public:
+   int shading, TimesToRefine;
+
+   Array<int> el_attr_to_show;
+
+   VisualizationSceneSolution1d(Mesh &m, Vector &s);
+
+   virtual ~VisualizationSceneSolution1d();
+
+   void SetGridFunction(GridFunction &u) { rsol = &u; }
+
+   void NewMeshAndSolution(Mesh *new_m, Vector *new_sol,
+                           GridFunction *new_u = NULL);
+
+   virtual void SetNewScalingFromBox();
+   virtual void FindNewBox(bool prepare);
+   virtual void FindNewValueRange(bool prepare);
+   virtual void FindNewBoxAndValueRange(bool prepare)
+   { FindNewBox(prepare); }
+   virtual void FindMeshBox(bool prepare);
+
+   virtual void ToggleLogscale(bool print);
+   virtual void UpdateLevelLines() { PrepareLevelLines(); }
+   virtual void UpdateValueRange(bool prepare);
+
+   virtual void Prepare();
+   virtual void PrepareLines();
+   void PrepareLevelLines();
+
+   virtual void Draw();
+
+   void ToggleDrawElems() { drawelems = !drawelems; }
+
+   // 0 - none, 1 - element end points, 2 - level lines
+   void ToggleDrawMesh() { drawmesh = (drawmesh+1)%3; }
+
+   virtual void SetShading(int, bool);
+   void ToggleShading();
+
+   virtual void SetRefineFactors(int, int);
+   virtual void AutoRefine();
+   virtual void ToggleAttributes(Array<int> &attr_list);
+};
+
+#endif
@@ -0,0 +1,257 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include "warmpool.hpp"
+#include "zstream.hpp"
+
+using namespace std;
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static int SendAll(int fd, const void *data, size_t size)
+{
+   const char *p = (const char *)data;
+   while (size > 0)
+   {
+      ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR)
+      {
+         continue;
+      }
+      if (n <= 0)
+      {
+         return 1;
+      }
+      p += n;
+      size -= n;
+   }
+   return 0;
+}
+
+static int ReceiveAll(int fd, void *data, size_t size)
+{
+   char *p = (char *)data;
+   while (size > 0)
+   {
+      ssize_t n = recv(fd, p, size, 0);
+      if (n < 0 && errno == EINTR)
+      {
+         continue;
+      }
+      if (n <= 0)
+      {
+         return 1;
+      }
+      p += n;
+      size -= n;
+   }
+   return 0;
+}
+
+static int SendString(int fd, const string &s)
+{
+   int size = int(s.size());
+   return (SendAll(fd, &size, sizeof(size)) ||
+           SendAll(fd, s.data(), s.size()));
+}
+
+static int ReceiveString(int fd, string &s)
+{
+   int size;
+   if (ReceiveAll(fd, &size, sizeof(size)) || size < 0)
+   {
+      return 1;
+   }
+   s.resize(size);
+   return (size > 0) ? ReceiveAll(fd, &s[0], size) : 0;
+}
+
+// Send the descriptor 'sd' with a one-byte message
+static int SendDescriptor(int fd, int sd)
+{
+   char byte = 0;
+   iovec iov;
+   iov.iov_base = &byte;
+   iov.iov_len = 1;
+
+   char cbuf[CMSG_SPACE(sizeof(int))];
+   memset(cbuf, 0, sizeof(cbuf));
+   msghdr msg;
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_iov = &iov;
+   msg.msg_iovlen = 1;
+   msg.msg_control = cbuf;
+   msg.msg_controllen = sizeof(cbuf);
+
+   cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+   cmsg->cmsg_level = SOL_SOCKET;
+   cmsg->cmsg_type = SCM_RIGHTS;
+   cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+   memcpy(CMSG_DATA(cmsg), &sd, sizeof(int));
+
+   ssize_t n;
+   do
+   {
+      n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+   }
+   while (n < 0 && errno == EINTR);
+   return (n == 1) ? 0 : 1;
+}
+
+static int ReceiveDescriptor(int fd)
+{
+   char byte;
+   iovec iov;
+   iov.iov_base = &byte;
+   iov.iov_len = 1;
+
+   char cbuf[CMSG_SPACE(sizeof(int))];
+   msghdr msg;
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_iov = &iov;
+   msg.msg_iovlen = 1;
+   msg.msg_control = cbuf;
+   msg.msg_controllen = sizeof(cbuf);
+
+   ssize_t n;
+   do
+   {
+      n = recvmsg(fd, &msg, 0);
+   }
+   while (n < 0 && errno == EINTR);
+   cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+   if (n != 1 || cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET ||
+       cmsg->cmsg_type != SCM_RIGHTS)
+   {
+      return -1;
+   }
+   int sd;
+   memcpy(&sd, CMSG_DATA(cmsg), sizeof(int));
+   return sd;
+}
+
+// Return the data buffered in 'sb', leaving it there
+static string PeekBuffered(streambuf *sb)
+{
+   string s;
+   streamsize n = sb->in_avail();
+   if (n > 0)
+   {
+      s.resize(n);
+      n = sb->sgetn(&s[0], n);
+      s.resize(n);
+      for (streamsize i = n-1; i >= 0; i--)
+      {
+         sb->sputbackc(s[i]);
+      }
+   }
+   return s;
+}
+
+// The socket stream of 'is' and, if 'is' is an izstream, 'is' itself
+static socketstream *SplitStream(istream *is, izstream *&zis)
+{
+   zis = dynamic_cast<izstream *>(is);
+   return dynamic_cast<socketstream *>(zis ? zis->Source() : is);
+}
+
+bool CanSendSession(Array<istream *> &streams)
+{
+   for (int i = 0; i < streams.Size(); i++)
+   {
+      izstream *zis;
+      socketstream *sock = SplitStream(streams[i], zis);
+      if (!sock)
+      {
+         return false;
+      }
+#ifdef MFEM_USE_GNUTLS
+      if (dynamic_cast<GnuTLS_socketbuf *>(sock->rdbuf()))
+      {
+         return false;
+      }
+#endif
+   }
+   return true;
+}
+
+int SendSession(int channel, const string &data_type,
+                Array<istream *> &streams)
+{
+   const int n = streams.Size();
+   if (SendString(channel, data_type) || SendAll(channel, &n, sizeof(n)))
+   {
+      return 1;
+   }
+   for (int i = 0; i < n; i++)
+   {
+      izstream *zis;
+      socketstream *sock = SplitStream(streams[i], zis);
+      const int compressed = zis ? 1 : 0;
+      if (!sock ||
+          SendDescriptor(channel, sock->rdbuf()->getsocketdescriptor()) ||
+          SendAll(channel, &compressed, sizeof(compressed)) ||
+          SendString(channel, PeekBuffered(sock->rdbuf())) ||
+          SendString(channel, zis ? PeekBuffered(zis->rdbuf()) : string()))
+      {
+         return 1;
+      }
+   }
+   return 0;
+}
+
+int ReceiveSession(int channel, string &data_type, Array<istream *> &streams)
+{
+   int n;
+   if (ReceiveString(channel, data_type) ||
+       ReceiveAll(channel, &n, sizeof(n)))
+   {
+      return 1;
+   }
+   for (int i = 0; i < n; i++)
+   {
+      int compressed;
+      string raw, decompressed;
+      const int sd = ReceiveDescriptor(channel);
+      if (sd < 0)
+      {
+         return 1;
+      }
+      if (ReceiveAll(channel, &compressed, sizeof(compressed)) ||
+          ReceiveString(channel, raw) || ReceiveString(channel, decompressed))
+      {
+         close(sd);
+         return 1;
+      }
+      istream *is = new socketstream(sd, false);
+      if (!raw.empty())
+      {
+         is = new prefixstream(raw, is);
+      }
+      if (compressed)
+      {
+         is = new izstream(is, true);
+      }
+      if (!decompressed.empty())
+      {
+         is = new prefixstream(decompressed, is);
+      }
+      streams.Append(is);
+   }
+   return 0;
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+
+#ifndef GLVIS_WARMPOOL
+#define GLVIS_WARMPOOL
+
+#include <iostream>
+#include <string>
+#include "mfem.hpp"
+using namespace mfem;
+
+// Hand-off of server sessions to pre-forked ("warm") worker processes, which
+// initialize the display connection, the OpenGL context and the font while
+// waiting for a session. The server sends the socket descriptors of the
+// session through a UNIX domain socket, together with the data that it had
+// already buffered but not read, so the worker continues reading the streams
+// where the server stopped. Secure (GnuTLS) streams can not be handed off.
+
+/// Return true if the streams of a session can be sent with SendSession():
+/// they must read from plain (not GnuTLS) sockets, possibly through an
+/// izstream.
+bool CanSendSession(Array<std::istream *> &streams);
+
+/// Send the data type and the streams of a session through the UNIX domain
+/// socket 'channel'. The streams are not modified, so on failure (non-zero
+/// return value) they can still be read by the server.
+int SendSession(int channel, const std::string &data_type,
+                Array<std::istream *> &streams);
+
+/// Receive a session sent with SendSession(), appending the new streams to
+/// 'streams'. Returns 0 on success.
+int ReceiveSession(int channel, std::string &data_type,
+                   Array<std::istream *> &streams);
+
+#endif
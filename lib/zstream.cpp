@@ -0,0 +1,462 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "visual.hpp"
+#ifdef GLVIS_USE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace std;
+
+// upper bound for the size of a frame, to detect corrupted data
+static const unsigned max_frame_size = 1u << 30;
+
+bool ZStreamCodecSupported(const string &codec)
+{
+#ifdef GLVIS_USE_ZLIB
+   return (codec == "zlib");
+#else
+   return false;
+#endif
+}
+
+static unsigned ReadLittleEndian32(const unsigned char *p)
+{
+   return (unsigned(p[0]) | (unsigned(p[1]) << 8) | (unsigned(p[2]) << 16) |
+           (unsigned(p[3]) << 24));
+}
+
+zstreambuf::int_type zstreambuf::underflow()
+{
+   if (gptr() < egptr())
+   {
+      return traits_type::to_int_type(*gptr());
+   }
+#ifdef GLVIS_USE_ZLIB
+   unsigned raw_size = 0, comp_size;
+   while (raw_size == 0) // skip empty frames
+   {
+      unsigned char header[8];
+      if (!src->read((char *)header, 8))
+      {
+         return traits_type::eof();
+      }
+      raw_size  = ReadLittleEndian32(header);
+      comp_size = ReadLittleEndian32(header + 4);
+      if (raw_size > max_frame_size || comp_size > max_frame_size)
+      {
+         cerr << "zstreambuf: invalid frame size" << endl;
+         return traits_type::eof();
+      }
+      in_buf.SetSize(comp_size);
+      if (!src->read(in_buf.GetData(), comp_size))
+      {
+         return traits_type::eof();
+      }
+   }
+   out_buf.SetSize(raw_size);
+   uLongf dest_size = raw_size;
+   if (uncompress((Bytef *)out_buf.GetData(), &dest_size,
+                  (const Bytef *)in_buf.GetData(), comp_size) != Z_OK ||
+       dest_size != raw_size)
+   {
+      cerr << "zstreambuf: error decompressing frame" << endl;
+      return traits_type::eof();
+   }
+   setg(out_buf.GetData(), out_buf.GetData(), out_buf.GetData() + raw_size);
+   return traits_type::to_int_type(*gptr());
+#else
+   return traits_type::eof();
+#endif
+}
+
+prefixstreambuf::prefixstreambuf(const string &_prefix, streambuf *_src)
+   : prefix(_prefix), src(_src), buf(4096), in_buf(false)
+{
+   char *p = prefix.empty() ? NULL : &prefix[0];
+   setg(p, p, p + prefix.size());
+}
+
+prefixstreambuf::~prefixstreambuf()
+{
+   if (in_buf)
+   {
+      for (char *p = egptr(); p > gptr(); )
+      {
+         src->sputbackc(*--p);
+      }
+   }
+}
+
+prefixstreambuf::int_type prefixstreambuf::underflow()
+{
+   if (gptr() < egptr())
+   {
+      return traits_type::to_int_type(*gptr());
+   }
+   // wait for data, then copy what is available in the source buffer, without
+   // waiting for more, so that it can be put back
+   if (src->sgetc() == traits_type::eof())
+   {
+      return traits_type::eof();
+   }
+   streamsize n = src->in_avail();
+   n = (n < 1) ? 1 : ((n > buf.Size()) ? buf.Size() : n);
+   n = src->sgetn(buf.GetData(), n);
+   in_buf = true;
+   setg(buf.GetData(), buf.GetData(), buf.GetData() + n);
+   return traits_type::to_int_type(*gptr());
+}
+
+// size of the chunks of decompressed data of non-BGZF members, and maximum
+// number of chunks decompressed ahead of the reader
+static const int gz_chunk_size = 1 << 20;
+static const size_t gz_max_chunks = 8;
+
+gzfilestreambuf::gzfilestreambuf(const char *filename)
+   : data(NULL), size(0), current(NULL), done(false), stop(false)
+{
+   pthread_mutex_init(&mutex, NULL);
+   pthread_cond_init(&cond, NULL);
+   int fd = open(filename, O_RDONLY);
+   if (fd >= 0)
+   {
+      struct stat st;
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+      {
+         void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (p != MAP_FAILED)
+         {
+            data = (char *)p;
+            size = st.st_size;
+            madvise(data, size, MADV_SEQUENTIAL);
+         }
+      }
+      close(fd);
+   }
+   if (pthread_create(&thread, NULL, DecompressThread, this) != 0)
+   {
+      done = true;
+      thread = pthread_self();
+   }
+}
+
+void *gzfilestreambuf::DecompressThread(void *p)
+{
+   gzfilestreambuf *_this = (gzfilestreambuf *)p;
+   _this->Decompress();
+   pthread_mutex_lock(&_this->mutex);
+   _this->done = true;
+   pthread_cond_broadcast(&_this->cond);
+   pthread_mutex_unlock(&_this->mutex);
+   return NULL;
+}
+
+// Add a chunk of decompressed data for the reader, waiting while it is too far
+// behind. Returns false if the reader is gone.
+bool gzfilestreambuf::Push(Array<char> *chunk)
+{
+   pthread_mutex_lock(&mutex);
+   while (chunks.size() >= gz_max_chunks && !stop)
+   {
+      pthread_cond_wait(&cond, &mutex);
+   }
+   const bool pushed = !stop;
+   if (pushed)
+   {
+      chunks.push_back(chunk);
+      pthread_cond_broadcast(&cond);
+   }
+   pthread_mutex_unlock(&mutex);
+   if (!pushed)
+   {
+      delete chunk;
+   }
+   return pushed;
+}
+
+// the maximum uncompressed size of a BGZF block
+static const size_t bgzf_max_isize = 65536;
+
+// If a BGZF block starts at p, return its size, otherwise return 0
+static size_t BGZFBlockSize(const unsigned char *p, size_t avail)
+{
+   // gzip magic, deflate, FEXTRA flag; XLEN at offset 10
+   if (avail < 18 || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8 ||
+       !(p[3] & 4))
+   {
+      return 0;
+   }
+   const size_t xlen = p[10] | (p[11] << 8);
+   for (size_t i = 12; i + 4 <= 12 + xlen && i + 4 <= avail; )
+   {
+      const size_t slen = p[i+2] | (p[i+3] << 8);
+      if (p[i] == 'B' && p[i+1] == 'C' && slen == 2 && i + 6 <= avail)
+      {
+         const size_t bsize = (p[i+4] | (p[i+5] << 8)) + 1;
+         return (bsize <= avail && bsize >= 12 + xlen + 8) ? bsize : 0;
+      }
+      i += 4 + slen;
+   }
+   return 0;
+}
+
+#ifdef GLVIS_USE_ZLIB
+// A batch of BGZF blocks decompressed with ParallelFor()
+struct BGZFBatch
+{
+   const unsigned char *data;
+   Array<size_t> offset;  // block i is [offset[i], offset[i+1])
+   Array<size_t> out_pos; // the output of block i starts at out_pos[i]
+   Array<char> *out;
+   int error;
+};
+
+static void InflateBGZFBlock(int i, void *p)
+{
+   BGZFBatch &b = *(BGZFBatch *)p;
+   const size_t out_size = b.out_pos[i+1] - b.out_pos[i];
+   z_stream z;
+   z.zalloc = Z_NULL;
+   z.zfree = Z_NULL;
+   z.opaque = Z_NULL;
+   z.next_in = (Bytef *)(b.data + b.offset[i]);
+   z.avail_in = b.offset[i+1] - b.offset[i];
+   if (inflateInit2(&z, 15 + 16) != Z_OK) // gzip format
+   {
+      __atomic_store_n(&b.error, 1, __ATOMIC_RELAXED);
+      return;
+   }
+   // zlib rejects a NULL output buffer, e.g. of a batch with only empty
+   // blocks, such as the BGZF end-of-file marker
+   Bytef empty;
+   z.next_out = out_size ? (Bytef *)(b.out->GetData() + b.out_pos[i]) : &empty;
+   z.avail_out = out_size;
+   if (inflate(&z, Z_FINISH) != Z_STREAM_END || z.total_out != out_size)
+   {
+      __atomic_store_n(&b.error, 1, __ATOMIC_RELAXED);
+   }
+   inflateEnd(&z);
+}
+#endif
+
+// Decompress a batch of consecutive BGZF blocks starting at 'pos' and return
+// the position after them, or 0 on error
+size_t gzfilestreambuf::InflateBlocks(size_t pos)
+{
+#ifdef GLVIS_USE_ZLIB
+   const unsigned char *p = (const unsigned char *)data;
+   const int max_blocks = 4*GetNumWorkerThreads();
+   BGZFBatch b;
+   b.data = p;
+   b.offset.Append(pos);
+   b.out_pos.Append(0);
+   size_t bsize;
+   // the output of the batch is an Array<char>, whose size is an int
+   while (b.offset.Size() <= max_blocks &&
+          b.out_pos.Last() <= size_t(INT_MAX) - bgzf_max_isize &&
+          (bsize = BGZFBlockSize(p + pos, size - pos)) > 0)
+   {
+      // the uncompressed size is the last 4 bytes of the block
+      const size_t isize = ReadLittleEndian32(p + pos + bsize - 4);
+      if (isize > bgzf_max_isize)
+      {
+         return 0;
+      }
+      pos += bsize;
+      b.offset.Append(pos);
+      b.out_pos.Append(b.out_pos.Last() + isize);
+   }
+   b.out = new Array<char>(b.out_pos.Last());
+   b.error = 0;
+   ParallelFor(b.offset.Size() - 1, InflateBGZFBlock, &b);
+   if (b.error)
+   {
+      delete b.out;
+      return 0;
+   }
+   if (b.out->Size() == 0)
+   {
+      delete b.out;
+      return pos;
+   }
+   return Push(b.out) ? pos : 0;
+#else
+   return 0;
+#endif
+}
+
+// Decompress the gzip member starting at 'pos' and return the position after
+// it, or 0 on error
+size_t gzfilestreambuf::InflateMember(size_t pos)
+{
+#ifdef GLVIS_USE_ZLIB
+   z_stream z;
+   z.zalloc = Z_NULL;
+   z.zfree = Z_NULL;
+   z.opaque = Z_NULL;
+   z.next_in = (Bytef *)(data + pos);
+   z.avail_in = size - pos;
+   if (inflateInit2(&z, 15 + 16) != Z_OK)
+   {
+      return 0;
+   }
+   int err = Z_OK;
+   while (err == Z_OK)
+   {
+      Array<char> *chunk = new Array<char>(gz_chunk_size);
+      z.next_out = (Bytef *)chunk->GetData();
+      z.avail_out = gz_chunk_size;
+      err = inflate(&z, Z_NO_FLUSH);
+      if (err != Z_OK && err != Z_STREAM_END)
+      {
+         delete chunk;
+         break;
+      }
+      chunk->SetSize(gz_chunk_size - z.avail_out);
+      if (!Push(chunk))
+      {
+         err = Z_ERRNO;
+      }
+   }
+   const size_t end = size - z.avail_in;
+   inflateEnd(&z);
+   return (err == Z_STREAM_END) ? end : 0;
+#else
+   return 0;
+#endif
+}
+
+void gzfilestreambuf::Decompress()
+{
+   const unsigned char *p = (const unsigned char *)data;
+   size_t pos = 0;
+   // decompress the gzip members until the end of the file; like gzip, ignore
+   // trailing data that is not a gzip member
+   while (pos + 2 <= size && p[pos] == 0x1f && p[pos+1] == 0x8b)
+   {
+      pos = BGZFBlockSize(p + pos, size - pos) ? InflateBlocks(pos) :
+            InflateMember(pos);
+      if (pos == 0)
+      {
+         pthread_mutex_lock(&mutex);
+         if (!stop)
+         {
+            cerr << "gzfilestreambuf: error decompressing the data" << endl;
+         }
+         pthread_mutex_unlock(&mutex);
+         break;
+      }
+   }
+}
+
+gzfilestreambuf::int_type gzfilestreambuf::underflow()
+{
+   if (gptr() < egptr())
+   {
+      return traits_type::to_int_type(*gptr());
+   }
+   pthread_mutex_lock(&mutex);
+   delete current;
+   current = NULL;
+   while (chunks.empty() && !done)
+   {
+      pthread_cond_wait(&cond, &mutex);
+   }
+   if (!chunks.empty())
+   {
+      current = chunks.front();
+      chunks.pop_front();
+      pthread_cond_broadcast(&cond);
+   }
+   pthread_mutex_unlock(&mutex);
+   if (current == NULL)
+   {
+      return traits_type::eof();
+   }
+   char *p = current->GetData();
+   setg(p, p, p + current->Size());
+   return traits_type::to_int_type(*gptr());
+}
+
+gzfilestreambuf::~gzfilestreambuf()
+{
+   pthread_mutex_lock(&mutex);
+   stop = true;
+   pthread_cond_broadcast(&cond);
+   pthread_mutex_unlock(&mutex);
+   if (!pthread_equal(thread, pthread_self()))
+   {
+      pthread_join(thread, NULL);
+   }
+   for (size_t i = 0; i < chunks.size(); i++)
+   {
+      delete chunks[i];
+   }
+   delete current;
+   if (data)
+   {
+      munmap(data, size);
+   }
+   pthread_cond_destroy(&cond);
+   pthread_mutex_destroy(&mutex);
+}
+
+ifpgzstream::ifpgzstream(const char *filename)
+   : std::istream(NULL), buf(NULL), src(NULL)
+{
+#ifdef GLVIS_USE_ZLIB
+   unsigned char magic[2] = { 0, 0 };
+   int fd = open(filename, O_RDONLY);
+   const bool gzip = (fd >= 0 && ::read(fd, magic, 2) == 2 &&
+                      magic[0] == 0x1f && magic[1] == 0x8b);
+   if (fd >= 0)
+   {
+      close(fd);
+   }
+   if (gzip)
+   {
+      buf = new gzfilestreambuf(filename);
+      rdbuf(buf);
+      return;
+   }
+#endif
+   src = new ifgzstream(filename);
+   rdbuf(src->rdbuf());
+   if (!*src)
+   {
+      setstate(ios::failbit);
+   }
+}
+
+socketstream *GetSocketStream(istream *is)
+{
+   socketstream *sock = dynamic_cast<socketstream *>(is);
+   if (sock == NULL)
+   {
+      izstream *zis = dynamic_cast<izstream *>(is);
+      prefixstream *pis = dynamic_cast<prefixstream *>(is);
+      if (zis)
+      {
+         sock = GetSocketStream(zis->Source());
+      }
+      else if (pis)
+      {
+         sock = GetSocketStream(pis->Source());
+      }
+   }
+   return sock;
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2010, Lawrence Livermore National Security, LLC. Produced at
+// the Lawrence Livermore National Laboratory. LLNL-CODE-443271. All Rights
+// reserved. See file COPYRIGHT for details.
+//
+// This file is part of the GLVis visualization tool and library. For more
+// information and source code availability see http://glvis.org.
+//
+// GLVis is free software; you can redistribute it and/or modify it under the
+// terms of the GNU Lesser General Public License (as published by the Free
+// Software Foundation) version 2.1 dated February 1999.
+
+#ifndef GLVIS_ZSTREAM
+#define GLVIS_ZSTREAM
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include <pthread.h>
+#include "mfem.hpp"
+using namespace mfem;
+
+// Compressed socket streams: a client requests compression by sending the line
+// "compressed zlib" (terminated by a single '\n') right after connecting. All
+// following data, starting with the data type keyword, is sent in frames
+// consisting of the uncompressed and the compressed size of the frame, as
+// 32-bit little-endian integers, followed by the frame data compressed with
+// zlib's compress(). Clients typically send one frame per flush.
+
+/// Return true if the given compression codec is supported.
+bool ZStreamCodecSupported(const std::string &codec);
+
+class zstreambuf : public std::streambuf
+{
+private:
+   std::istream *src;
+   Array<char> in_buf, out_buf;
+
+protected:
+   virtual int_type underflow();
+
+public:
+   zstreambuf(std::istream *_src) : src(_src) { }
+};
+
+/// Input stream decompressing the frames read from another stream.
+class izstream : public std::istream
+{
+private:
+   zstreambuf buf;
+   std::istream *src;
+   bool own_src;
+
+public:
+   izstream(std::istream *_src, bool _own_src)
+      : std::istream(NULL), buf(_src), src(_src), own_src(_own_src)
+   { rdbuf(&buf); }
+
+   std::istream *Source() { return src; }
+
+   virtual ~izstream() { if (own_src) { delete src; } }
+};
+
+/// Stream buffer reading the string 'prefix' followed by the rest of another
+/// buffer. The data of the other buffer is copied in blocks of what it has
+/// buffered, and the unread part of the last block is put back on destruction,
+/// so that the other buffer is not read ahead.
+class prefixstreambuf : public std::streambuf
+{
+private:
+   std::string prefix;
+   std::streambuf *src;
+   Array<char> buf;
+   bool in_buf; // reading from 'buf', not from 'prefix'
+
+protected:
+   virtual int_type underflow();
+
+public:
+   prefixstreambuf(const std::string &_prefix, std::streambuf *_src);
+
+   virtual ~prefixstreambuf();
+};
+
+/// Input stream reading the string 'prefix' followed by the data of another
+/// stream, which it owns. Used to continue reading a stream in another process
+/// from the data that was buffered, but not read, in the original process.
+class prefixstream : public std::istream
+{
+private:
+   prefixstreambuf *buf; // deleted before 'src', into which it puts data back
+   std::istream *src;
+
+public:
+   prefixstream(const std::string &prefix, std::istream *_src)
+      : std::istream(NULL), buf(new prefixstreambuf(prefix, _src->rdbuf())),
+        src(_src)
+   { rdbuf(buf); }
+
+   std::istream *Source() { return src; }
+
+   virtual ~prefixstream() { delete buf; delete src; }
+};
+
+/// Stream buffer decompressing a gzip file in a separate thread, so that the
+/// decompression overlaps with the parsing of the data. The members of BGZF
+/// files (multi-member gzip files with the compressed size of every member in
+/// its header, as written by bgzip) are decompressed concurrently, in batches.
+class gzfilestreambuf : public std::streambuf
+{
+private:
+   char *data; // the mapped file
+   size_t size;
+   std::deque<Array<char> *> chunks; // decompressed data, not yet read
+   Array<char> *current;             // the chunk being read
+   bool done, stop;
+   pthread_t thread;
+   pthread_mutex_t mutex;
+   pthread_cond_t cond;
+
+   static void *DecompressThread(void *p);
+   void Decompress();
+   size_t InflateBlocks(size_t pos);
+   size_t InflateMember(size_t pos);
+   bool Push(Array<char> *chunk);
+
+protected:
+   virtual int_type underflow();
+
+public:
+   /// Decompress the gzip data of the file 'filename'; the stream is empty if
+   /// the file can not be mapped.
+   gzfilestreambuf(const char *filename);
+
+   virtual ~gzfilestreambuf();
+};
+
+/// Input file stream, like ifgzstream: gzip-compressed files are decompressed
+/// with a gzfilestreambuf (with zlib) and other files are read directly.
+class ifpgzstream : public std::istream
+{
+private:
+   std::streambuf *buf;
+   std::istream *src;
+
+public:
+   ifpgzstream(const char *filename);
+
+   virtual ~ifpgzstream() { delete buf; delete src; }
+};
+
+/// Return the socketstream underlying 'is' (possibly through izstreams and
+/// prefixstreams), or NULL if 'is' does not read from a socket.
+socketstream *GetSocketStream(std::istream *is);
+
+#endif